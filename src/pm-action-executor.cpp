@@ -0,0 +1,89 @@
+#include "pm-action-executor.hpp"
+
+#include <util/platform.h>
+
+const int PmActionExecutor::k_defaultConcurrency;
+
+template <typename T>
+static void storeMax(std::atomic<T> &maxVal, T val)
+{
+    T prev = maxVal.load();
+    while (val > prev && !maxVal.compare_exchange_weak(prev, val)) {}
+}
+
+PmActionExecutor::PmActionExecutor(int maxConcurrency)
+{
+    m_pool.setObjectName("pixel match action executor");
+    setMaxConcurrency(maxConcurrency);
+}
+
+PmActionExecutor::~PmActionExecutor()
+{
+    waitForDone();
+}
+
+void PmActionExecutor::setMaxConcurrency(int maxConcurrency)
+{
+    m_pool.setMaxThreadCount(maxConcurrency > 0 ? maxConcurrency : 1);
+}
+
+int PmActionExecutor::maxConcurrency() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void PmActionExecutor::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+uint64_t PmActionExecutor::avgExecNs() const
+{
+    uint64_t num = m_numExecuted.load();
+    return num ? m_totalExecNs.load() / num : 0;
+}
+
+void PmActionExecutor::submit(const std::string &target, Job job)
+{
+    bool idle;
+    {
+        QMutexLocker locker(&m_queuesMutex);
+        auto &queue = m_queues[target];
+        idle = queue.empty();
+        queue.push_back(std::move(job));
+
+        storeMax(m_maxQueueDepth, ++m_queueDepth);
+    }
+
+    // a busy target picks up the new job when it's done with the others
+    if (idle)
+        m_pool.start([this, target]() { runTarget(target); });
+}
+
+void PmActionExecutor::runTarget(const std::string &target)
+{
+    while (true) {
+        Job job;
+        {
+            QMutexLocker locker(&m_queuesMutex);
+            job = m_queues[target].front();
+        }
+
+        uint64_t startNs = os_gettime_ns();
+        job();
+        uint64_t execNs = os_gettime_ns() - startNs;
+
+        m_numExecuted++;
+        m_totalExecNs += execNs;
+        storeMax(m_maxExecNs, execNs);
+
+        QMutexLocker locker(&m_queuesMutex);
+        auto find = m_queues.find(target);
+        find->second.pop_front();
+        m_queueDepth--;
+        if (find->second.empty()) {
+            m_queues.erase(find);
+            return;
+        }
+    }
+}
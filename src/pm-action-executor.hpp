@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QMutex>
+#include <QThreadPool>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Runs reaction actions off the core thread. Jobs submitted for the
+ *        same target run one at a time, in submission order; jobs for
+ *        different targets run in parallel, up to the concurrency limit.
+ */
+class PmActionExecutor
+{
+public:
+    typedef std::function<void()> Job;
+
+    static const int k_defaultConcurrency = 2;
+
+    PmActionExecutor(int maxConcurrency = k_defaultConcurrency);
+    ~PmActionExecutor();
+
+    void submit(const std::string &target, Job job);
+    void waitForDone();
+
+    void setMaxConcurrency(int maxConcurrency);
+    int maxConcurrency() const;
+
+    // metrics
+    size_t queueDepth() const { return m_queueDepth.load(); }
+    size_t maxQueueDepth() const { return m_maxQueueDepth.load(); }
+    uint64_t numExecuted() const { return m_numExecuted.load(); }
+    uint64_t avgExecNs() const;
+    uint64_t maxExecNs() const { return m_maxExecNs.load(); }
+
+protected:
+    void runTarget(const std::string &target);
+
+    QThreadPool m_pool;
+
+    // per-target queues; the running job stays at the front of its queue,
+    // so a target with a non-empty queue already has a worker
+    QMutex m_queuesMutex;
+    std::unordered_map<std::string, std::deque<Job>> m_queues;
+
+    std::atomic<size_t> m_queueDepth{0};
+    std::atomic<size_t> m_maxQueueDepth{0};
+    std::atomic<uint64_t> m_numExecuted{0};
+    std::atomic<uint64_t> m_totalExecNs{0};
+    std::atomic<uint64_t> m_maxExecNs{0};
+};
@@ -0,0 +1,131 @@
+#include "pm-compiled-config.hpp"
+
+static PmSceneTarget resolveScene(
+    const PmReaction &reaction, bool matched, const PmSceneGraph &graph)
+{
+    PmSceneTarget ret;
+    if (matched)
+        reaction.getMatchScene(ret.sceneName, ret.transition);
+    else
+        reaction.getUnmatchScene(ret.sceneName, ret.transition);
+    if (ret.sceneName.size()) {
+        auto find = graph.scenes.find(ret.sceneName);
+        if (find != graph.scenes.end()) {
+            ret.sceneExists = true;
+            ret.sceneWs = find->wsrc;
+        }
+    }
+    if (ret.transition.size()) {
+        auto find = graph.transitions.find(ret.transition);
+        if (find != graph.transitions.end())
+            ret.transitionWs = *find;
+    }
+    return ret;
+}
+
+static PmActionPlan resolvePlan(
+    const std::vector<PmAction> &actions, const PmSceneGraph &graph)
+{
+    PmActionPlan ret;
+    for (const PmAction &action : actions) {
+        if (!action.isSet())
+            continue;
+
+        PmActionStep step;
+        step.action = &action;
+        switch (action.actionType) {
+        case PmActionType::SceneItem: {
+            auto find = graph.sceneItems.find(action.targetElement);
+            if (find == graph.sceneItems.end())
+                continue;
+            step.sceneItem = find->si;
+            break;
+        }
+        case PmActionType::Filter: {
+            auto find = graph.filters.find(action.targetElement);
+            if (find == graph.filters.end())
+                continue;
+            step.wsrc = find->wsrc;
+            break;
+        }
+        case PmActionType::ToggleMute: {
+            auto find = graph.audioSources.find(action.targetElement);
+            if (find == graph.audioSources.end())
+                continue;
+            step.wsrc = find->wsrc;
+            break;
+        }
+        case PmActionType::Hotkey:
+        case PmActionType::FrontEndAction:
+        case PmActionType::File:
+            break;
+        default:
+            // scenes are switched separately
+            continue;
+        }
+        ret.push_back(step);
+    }
+    return ret;
+}
+
+static bool anySet(const std::vector<PmAction> &actions)
+{
+    for (const PmAction &action : actions) {
+        if (action.isSet())
+            return true;
+    }
+    return false;
+}
+
+PmCompiledConfig::PmCompiledConfig(
+    const PmMultiMatchConfig &cfg, const PmSceneGraph &graph)
+{
+    size_t sz = cfg.size();
+    totalMatchThresh.reserve(sz);
+    invertResult.reserve(sz);
+    isEnabled.reserve(sz);
+    hasReaction.reserve(sz);
+    hasSceneAction.reserve(sz);
+    hasMatchSceneAction.reserve(sz);
+    hasSetMatchActions.reserve(sz);
+    hasSetUnmatchActions.reserve(sz);
+    lingerMs.reserve(sz);
+    cooldownMs.reserve(sz);
+    matchScene.reserve(sz);
+    unmatchScene.reserve(sz);
+    labels.reserve(sz);
+    reactions.reserve(sz);
+    matchPlans.reserve(sz);
+    unmatchPlans.reserve(sz);
+
+    for (const PmMatchConfig &mc : cfg) {
+        const PmReaction &reaction = mc.reaction;
+        totalMatchThresh.push_back(mc.totalMatchThresh);
+        invertResult.push_back(mc.invertResult);
+        isEnabled.push_back(mc.filterCfg.is_enabled);
+        hasReaction.push_back(reaction.isSet());
+        hasSceneAction.push_back(reaction.hasSceneAction());
+        hasMatchSceneAction.push_back(
+            reaction.hasMatchAction(PmActionType::Scene));
+        hasSetMatchActions.push_back(anySet(reaction.matchActions));
+        hasSetUnmatchActions.push_back(anySet(reaction.unmatchActions));
+        lingerMs.push_back(reaction.lingerMs);
+        cooldownMs.push_back(reaction.cooldownMs);
+        matchScene.push_back(resolveScene(reaction, true, graph));
+        unmatchScene.push_back(resolveScene(reaction, false, graph));
+        labels.push_back(mc.label);
+        reactions.push_back(reaction);
+    }
+
+    // plans are resolved once the reactions have their final addresses
+    for (const PmReaction &reaction : reactions) {
+        matchPlans.push_back(resolvePlan(reaction.matchActions, graph));
+        unmatchPlans.push_back(resolvePlan(reaction.unmatchActions, graph));
+    }
+
+    noMatchReaction = cfg.noMatchReaction;
+    globalMatchScene = resolveScene(noMatchReaction, true, graph);
+    globalUnmatchScene = resolveScene(noMatchReaction, false, graph);
+    globalMatchPlan = resolvePlan(noMatchReaction.matchActions, graph);
+    globalUnmatchPlan = resolvePlan(noMatchReaction.unmatchActions, graph);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "pm-structs.hpp"
+
+#include <memory>
+
+/**
+ * @brief Scene switching target of a reaction, resolved at compile time
+ */
+struct PmSceneTarget
+{
+    std::string sceneName;
+    std::string transition;
+    bool sceneExists = false;
+
+    // resolved references; transition is null when not set or not found
+    OBSWeakSource sceneWs;
+    OBSWeakSource transitionWs;
+};
+
+/**
+ * @brief An action of a reaction, with its target already resolved.
+ *        Actions whose target doesn't exist are left out of the plan.
+ */
+struct PmActionStep
+{
+    const PmAction *action; // points into the owning PmCompiledConfig
+    OBSSceneItem sceneItem; // SceneItem actions
+    OBSWeakSource wsrc; // Filter and ToggleMute actions
+};
+
+typedef std::vector<PmActionStep> PmActionPlan;
+
+/**
+ * @brief Scene graph references that reactions are resolved against
+ */
+struct PmSceneGraph
+{
+    PmSourceHash scenes;
+    PmSceneItemsHash sceneItems;
+    PmSourceHash filters;
+    PmSourceHash audioSources;
+    QHash<std::string, OBSWeakSource> transitions;
+};
+
+/**
+ * @brief Read-only form of the match configuration for the per-frame
+ *        decision loop. Each property is stored as an array indexed by
+ *        match index. A new instance is compiled whenever the configuration
+ *        or the set of scenes changes; instances are never modified.
+ */
+class PmCompiledConfig
+{
+public:
+    PmCompiledConfig() {}
+    PmCompiledConfig(
+        const PmMultiMatchConfig &cfg, const PmSceneGraph &graph);
+
+    // plans point into the instance's own reactions
+    PmCompiledConfig(const PmCompiledConfig &) = delete;
+    PmCompiledConfig &operator=(const PmCompiledConfig &) = delete;
+
+    size_t size() const { return totalMatchThresh.size(); }
+
+    // matching
+    std::vector<float> totalMatchThresh;
+    std::vector<uint8_t> invertResult;
+    std::vector<uint8_t> isEnabled;
+
+    // reaction summaries
+    std::vector<uint8_t> hasReaction;
+    std::vector<uint8_t> hasSceneAction;
+    std::vector<uint8_t> hasMatchSceneAction;
+    std::vector<uint8_t> hasSetMatchActions;
+    std::vector<uint8_t> hasSetUnmatchActions;
+    std::vector<uint32_t> lingerMs;
+    std::vector<uint32_t> cooldownMs;
+    std::vector<PmSceneTarget> matchScene;
+    std::vector<PmSceneTarget> unmatchScene;
+
+    // needed only when actions are executed
+    std::vector<std::string> labels;
+    std::vector<PmReaction> reactions;
+    std::vector<PmActionPlan> matchPlans;
+    std::vector<PmActionPlan> unmatchPlans;
+
+    // no-match reaction
+    PmReaction noMatchReaction;
+    PmSceneTarget globalMatchScene;
+    PmSceneTarget globalUnmatchScene;
+    PmActionPlan globalMatchPlan;
+    PmActionPlan globalUnmatchPlan;
+};
+
+typedef std::shared_ptr<const PmCompiledConfig> PmCompiledConfigPtr;
@@ -1,10 +1,16 @@
 #include "pm-core.hpp"
+#include "pm-preset-pack.hpp"
 
 #include <ostream>
 #include <sstream>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+#include <set>
 
 #include <obs-frontend-api.h>
 #include <obs-data.h>
+#include <util/platform.h>
 
 #include <QAction>
 #include <QMainWindow>
@@ -33,8 +39,151 @@ struct PmSceneScanInfo
 
     PmSourceData *lastSceneData = nullptr;
     PmSceneItemData *lastSiData = nullptr;
+    PmCore *core = nullptr;
 };
 
+static const void *sourceIdentity(const PmSourceData &data)
+{
+    return (obs_weak_source_t *)data.wsrc;
+}
+
+static const void *sourceIdentity(const PmSceneItemData &data)
+{
+    return (obs_sceneitem_t *)data.si;
+}
+
+/**
+ * @brief Maps names that are gone from a scan to the new names of the same
+ *        sources, or to empty names when the sources are gone too
+ */
+template <typename Hash>
+static PmRenameMap findRenames(const Hash &oldHash, const Hash &newHash)
+{
+    std::unordered_map<const void *, std::string> newNames;
+    newNames.reserve(size_t(newHash.size()));
+    for (auto it = newHash.begin(); it != newHash.end(); ++it) {
+        newNames.emplace(sourceIdentity(it.value()), it.key());
+    }
+
+    PmRenameMap ret;
+    for (auto it = oldHash.begin(); it != oldHash.end(); ++it) {
+        if (newHash.contains(it.key()))
+            continue;
+        auto find = newNames.find(sourceIdentity(it.value()));
+        ret[it.key()] = (find != newNames.end()) ? find->second : "";
+    }
+    return ret;
+}
+
+static void nameDelta(const QSet<std::string> &oldNames,
+    const QSet<std::string> &newNames,
+    QList<std::string> &added, QList<std::string> &removed)
+{
+    for (const std::string &name : newNames) {
+        if (!oldNames.contains(name))
+            added.push_back(name);
+    }
+    for (const std::string &name : oldNames) {
+        if (!newNames.contains(name))
+            removed.push_back(name);
+    }
+}
+
+
+/**
+ * @brief Scene item, filter and mute toggles collected from one decision
+ *        pass. A later toggle of the same target replaces an earlier one.
+ */
+struct PmToggleBatch
+{
+    template <typename T>
+    static void set(std::vector<std::pair<T, bool>> &toggles,
+                    const T &target, bool on);
+    static void applySceneItems(void *data, obs_scene_t *scene);
+
+    void add(const PmActionStep &step);
+    void apply() const;
+    bool empty() const
+        { return sceneItems.empty() && filters.empty() && mutes.empty(); }
+
+    std::vector<std::pair<OBSSceneItem, bool>> sceneItems;
+    std::vector<std::pair<OBSWeakSource, bool>> filters;
+    std::vector<std::pair<OBSWeakSource, bool>> mutes; // true to unmute
+};
+
+template <typename T>
+void PmToggleBatch::set(
+    std::vector<std::pair<T, bool>> &toggles, const T &target, bool on)
+{
+    for (auto &toggle : toggles) {
+        if (toggle.first == target) {
+            toggle.second = on;
+            return;
+        }
+    }
+    toggles.emplace_back(target, on);
+}
+
+void PmToggleBatch::add(const PmActionStep &step)
+{
+    const PmAction &action = *step.action;
+    bool on = (action.actionCode == (size_t)PmToggleCode::On);
+    if (!on && action.actionCode != (size_t)PmToggleCode::Off)
+        return;
+
+    switch (action.actionType) {
+    case PmActionType::SceneItem: set(sceneItems, step.sceneItem, on); break;
+    case PmActionType::Filter: set(filters, step.wsrc, on); break;
+    case PmActionType::ToggleMute: set(mutes, step.wsrc, on); break;
+    default: break;
+    }
+}
+
+void PmToggleBatch::applySceneItems(void *data, obs_scene_t *scene)
+{
+    auto batch = static_cast<const PmToggleBatch *>(data);
+    for (const auto &toggle : batch->sceneItems) {
+        obs_sceneitem_t *sceneItem = toggle.first;
+        if (obs_sceneitem_get_scene(sceneItem) == scene
+         && obs_sceneitem_visible(sceneItem) != toggle.second) {
+            obs_sceneitem_set_visible(sceneItem, toggle.second);
+        }
+    }
+}
+
+void PmToggleBatch::apply() const
+{
+    // scene items change with their scene locked, one scene at a time,
+    // so a scene never renders with just some of its toggles applied
+    std::vector<obs_scene_t *> scenes;
+    for (const auto &toggle : sceneItems) {
+        obs_scene_t *scene = obs_sceneitem_get_scene(toggle.first);
+        if (scene
+         && std::find(scenes.begin(), scenes.end(), scene) == scenes.end()) {
+            scenes.push_back(scene);
+            obs_scene_atomic_update(scene, applySceneItems,
+                                    const_cast<PmToggleBatch *>(this));
+        }
+    }
+
+    for (const auto &toggle : filters) {
+        obs_source_t *filterSrc = obs_weak_source_get_source(toggle.first);
+        if (filterSrc) {
+            if (obs_source_enabled(filterSrc) != toggle.second)
+                obs_source_set_enabled(filterSrc, toggle.second);
+            obs_source_release(filterSrc);
+        }
+    }
+
+    for (const auto &toggle : mutes) {
+        obs_source_t *audioSrc = obs_weak_source_get_source(toggle.first);
+        if (audioSrc) {
+            if (obs_source_muted(audioSrc) == toggle.second)
+                obs_source_set_muted(audioSrc, !toggle.second);
+            obs_source_release(audioSrc);
+        }
+    }
+}
 
 PmCore* PmCore::m_instance = nullptr;
 
@@ -46,10 +195,14 @@ extern "C" void init_pixel_match_switcher(void)
 
     obs_frontend_add_save_callback(
         pm_save_load_callback, static_cast<void*>(PmCore::m_instance));
+    obs_frontend_add_event_callback(
+        pm_frontend_event_callback, static_cast<void*>(PmCore::m_instance));
 }
 
 extern "C" void free_pixel_match_switcher(void)
 {
+    obs_frontend_remove_event_callback(
+        pm_frontend_event_callback, static_cast<void*>(PmCore::m_instance));
     delete PmCore::m_instance;
     PmCore::m_instance = nullptr;
 }
@@ -64,25 +217,45 @@ void pm_save_load_callback(obs_data_t *save_data, bool saving, void *corePtr)
     }
 }
 
+void pm_frontend_event_callback(enum obs_frontend_event event, void *corePtr)
+{
+    PmCore *core = static_cast<PmCore *>(corePtr);
+    switch (event) {
+    case OBS_FRONTEND_EVENT_SCENE_CHANGED:
+    case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+    case OBS_FRONTEND_EVENT_FINISHED_LOADING:
+        core->updateCurrentScene();
+        break;
+    default:
+        break;
+    }
+}
+
 void on_frame_processed(pm_filter_data *filterData)
 {
     auto core = PmCore::m_instance;
     if (core) {
-        PmMultiMatchResults newResults;
-        pthread_mutex_lock(&filterData->mutex);
+        // called from the render thread, which owns the entries; results
+        // go into a preallocated slot and the core is woken up at most once
+        // until it catches up
+        auto &slot = core->m_resultsRing.writeSlot();
+        auto &newResults = slot.results;
         newResults.resize(filterData->num_match_entries);
         for (size_t i = 0; i < newResults.size(); ++i) {
             auto &newResult = newResults[i];
-            const auto &filterEntry = filterData->match_entries + i;
+            const auto &filterEntry = filterData->match_entries[i];
             newResult.baseWidth = filterData->base_width;
             newResult.baseHeight = filterData->base_height;
             newResult.matchImgWidth = filterEntry->match_img_width;
             newResult.matchImgHeight = filterEntry->match_img_height;
             newResult.numCompared = filterEntry->num_compared;
             newResult.numMatched = filterEntry->num_matched;
+            newResult.isReady = filterEntry->is_ready;
+            newResult.percentageMatched = 0.f;
+            newResult.isMatched = false;
         }
-        pthread_mutex_unlock(&filterData->mutex);
-        emit core->sigFrameProcessed(newResults);
+        if (core->m_resultsRing.publish())
+            emit core->sigFrameProcessed();
     }
 }
 
@@ -98,7 +271,6 @@ void on_match_image_captured(pm_filter_data *filterData)
 {
     auto core = PmCore::m_instance;
     if (core) {
-        pthread_mutex_lock(&filterData->mutex);
         int roiLeft = std::min(core->m_captureStartX, core->m_captureEndX);
         int roiBottom = std::min(core->m_captureStartY, core->m_captureEndY);
         int roiRight = std::max(core->m_captureStartX, core->m_captureEndX);
@@ -111,9 +283,57 @@ void on_match_image_captured(pm_filter_data *filterData)
         emit core->sigMatchImageCaptured(matchImg.copy(), roiLeft, roiBottom);
         bfree(filterData->captured_region_data);
         filterData->captured_region_data = nullptr;
-        filterData->filter_mode = PM_MATCH;
+        pm_set_filter_mode(filterData, PM_MATCH);
+    }
+}
 
-        pthread_mutex_unlock(&filterData->mutex);
+// visits image filenames of a saved preset, without parsing the preset
+template <typename F>
+static void forEachPresetImage(obs_data_t *presetObj, F func)
+{
+    obs_data_array_t *entriesArray = obs_data_get_array(presetObj, "entries");
+    size_t count = obs_data_array_count(entriesArray);
+    for (size_t i = 0; i < count; ++i) {
+        obs_data_t *entryObj = obs_data_array_item(entriesArray, i);
+        func(obs_data_get_string(entryObj, "match_image_filename"));
+        obs_data_release(entryObj);
+    }
+    obs_data_array_release(entriesArray);
+}
+
+/*
+ * @brief Finds the bounding box of pixels that will actually be compared,
+ *        according to the masking rules of the entry
+ */
+static QRect activeImageRegion(
+    const QImage &image, const pm_match_entry_config &cfg)
+{
+    int left = image.width(), right = -1;
+    int top = image.height(), bottom = -1;
+    QRgb maskRgb = qRgb(int(std::lround(cfg.mask_color.x * 255.f)),
+                        int(std::lround(cfg.mask_color.y * 255.f)),
+                        int(std::lround(cfg.mask_color.z * 255.f)));
+
+    for (int y = 0; y < image.height(); ++y) {
+        auto line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            bool active = cfg.mask_alpha
+                ? qAlpha(line[x]) > 0
+                : (line[x] & RGB_MASK) != (maskRgb & RGB_MASK);
+            if (active) {
+                left = std::min(left, x);
+                right = std::max(right, x);
+                top = std::min(top, y);
+                bottom = std::max(bottom, y);
+            }
+        }
+    }
+
+    if (right < 0) {
+        // nothing is active; leave the image alone
+        return image.rect();
+    } else {
+        return QRect(QPoint(left, top), QPoint(right, bottom));
     }
 }
 
@@ -156,6 +376,27 @@ PmCore::PmCore()
     connect(this, &PmCore::sigFrameProcessed,
             this, &PmCore::onFrameProcessed, Qt::QueuedConnection);
 
+    // changes to the scene graph are signaled by OBS
+    signal_handler_t *sh = obs_get_signal_handler();
+    signal_handler_connect(sh, "source_create", onSourceCreated, this);
+    signal_handler_connect(sh, "source_destroy", onSceneGraphSignal, this);
+    signal_handler_connect(sh, "source_remove", onSceneGraphSignal, this);
+    signal_handler_connect(sh, "source_rename", onSceneGraphSignal, this);
+
+    // lingers and cooldowns are expired on time, even between frames
+    m_deadlineTimer = new QTimer(this);
+    m_deadlineTimer->setSingleShot(true);
+    m_deadlineTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_deadlineTimer, &QTimer::timeout,
+            this, &PmCore::onDeadlineReached);
+
+    // bursts of edits from the UI are applied together
+    m_editTimer = new QTimer(this);
+    m_editTimer->setSingleShot(true);
+    m_editTimer->setInterval(k_editCoalesceMs);
+    connect(m_editTimer, &QTimer::timeout,
+            this, &PmCore::flushMatchConfigEdits);
+
     // move to own thread
     m_thread = new QThread(this);
     m_thread->setObjectName("pixel match core thread");
@@ -175,6 +416,22 @@ PmCore::~PmCore()
     while (m_thread->isRunning() || m_periodicUpdateActive) {
         QThread::msleep(1);
     }
+    m_actionExecutor.waitForDone();
+    m_fileWriter.stop();
+    cancelImageLoads();
+    m_imageIo.waitForDone();
+
+    signal_handler_t *sh = obs_get_signal_handler();
+    signal_handler_disconnect(sh, "source_create", onSourceCreated, this);
+    signal_handler_disconnect(sh, "source_destroy", onSceneGraphSignal, this);
+    signal_handler_disconnect(sh, "source_remove", onSceneGraphSignal, this);
+    signal_handler_disconnect(sh, "source_rename", onSceneGraphSignal, this);
+    auto disconnectAll = [](void *data, obs_source_t *source) -> bool {
+        disconnectSourceSignals(source, static_cast<PmCore *>(data));
+        return true;
+    };
+    obs_enum_sources(disconnectAll, this);
+    obs_enum_scenes(disconnectAll, this);
 
     if (m_dialog) {
         m_dialog->deleteLater();
@@ -190,6 +447,8 @@ void PmCore::activate()
 
     auto cfgCpy = multiMatchConfig();
     activateMultiMatchConfig(cfgCpy);
+    updateCurrentScene();
+    m_sceneGraphDirty = true;
 
     // fire up the engines
     m_periodicUpdateTimer->start(100);
@@ -217,12 +476,10 @@ void PmCore::deactivate()
         auto data = oldAfr.filterData();
         if (data) {
             pm_resize_match_entries(data, 0);
-            oldAfr.lockData();
-            data->on_frame_processed = nullptr;
-            data->on_match_image_captured = nullptr;
-            oldAfr.unlockData();
+            pm_set_filter_callbacks(data, nullptr, nullptr);
         }
     }
+    cancelImageLoads();
     {
         QMutexLocker locker(&m_matchImagesMutex);
         for (size_t i = 0; i < m_matchImages.size(); ++i) {
@@ -236,6 +493,7 @@ void PmCore::deactivate()
         }
         m_results.clear();
     }
+    m_decisionEngine.reset();
 
     moveToThread(QApplication::instance()->thread());
     m_thread->exit();
@@ -268,7 +526,11 @@ PmMatchResults PmCore::matchResults(size_t matchIdx) const
 PmMultiMatchConfig PmCore::multiMatchConfig() const
 {
     QMutexLocker locker(&m_matchConfigMutex);
-    return m_multiMatchConfig;
+    PmMultiMatchConfig ret = m_multiMatchConfig;
+    for (const auto &edit : m_pendingEdits) {
+        ret[edit.first] = edit.second;
+    }
+    return ret;
 }
 
 size_t PmCore::multiMatchConfigSize() const
@@ -280,6 +542,9 @@ size_t PmCore::multiMatchConfigSize() const
 PmMatchConfig PmCore::matchConfig(size_t matchIdx) const
 {
     QMutexLocker locker(&m_matchConfigMutex);
+    auto find = m_pendingEdits.find(matchIdx);
+    if (find != m_pendingEdits.end())
+        return find->second;
     return matchIdx < m_multiMatchConfig.size() ? m_multiMatchConfig[matchIdx]
                                                 : PmMatchConfig();
 }
@@ -419,6 +684,39 @@ bool PmCore::enforceTargetOrder(size_t matchIdx, const PmMatchConfig &newCfg)
     return false;
 }
 
+// same rules as enforceTargetOrder(), applied to a config that isn't active;
+// matchIdx follows the entry when it moves
+static bool moveToTargetOrder(PmMultiMatchConfig &mcfg, size_t &matchIdx)
+{
+    size_t sz = mcfg.size();
+    const PmMatchConfig cfg = mcfg[matchIdx];
+    if (sz <= 1 || !cfg.reaction.hasAction(PmActionType::ANY)) return false;
+
+    size_t newIdx = matchIdx;
+    if (!cfg.reaction.hasSceneAction()
+      && matchIdx < sz-1
+      && mcfg[matchIdx + 1].reaction.hasSceneAction()) {
+        // scenes after scene items
+        mcfg.erase(mcfg.begin() + int(matchIdx));
+        while (newIdx < sz-1 && mcfg[newIdx].reaction.hasSceneAction()) {
+            newIdx++;
+        }
+    } else if (cfg.reaction.hasSceneAction()
+            && matchIdx > 0
+            && !mcfg[matchIdx - 1].reaction.hasSceneAction()) {
+        // scene items before scenes
+        mcfg.erase(mcfg.begin() + int(matchIdx));
+        while (newIdx > 0 && !mcfg[newIdx - 1].reaction.hasSceneAction()) {
+            newIdx--;
+        }
+    } else {
+        return false;
+    }
+    mcfg.insert(mcfg.begin() + int(newIdx), cfg);
+    matchIdx = newIdx;
+    return true;
+}
+
 void PmCore::onMatchConfigChanged(size_t matchIdx, PmMatchConfig newCfg)
 {
     size_t sz = multiMatchConfigSize();
@@ -426,6 +724,12 @@ void PmCore::onMatchConfigChanged(size_t matchIdx, PmMatchConfig newCfg)
     // invalid index?
     if (matchIdx >= sz) return; 
 
+    // a direct change supersedes a pending edit of the same entry
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        m_pendingEdits.erase(matchIdx);
+    }
+
     PmMatchConfig oldCfg = matchConfig(matchIdx);
 
      // config hasn't changed? stop callback loops
@@ -437,98 +741,174 @@ void PmCore::onMatchConfigChanged(size_t matchIdx, PmMatchConfig newCfg)
     // go forward with setting new config state and activation
     activateMatchConfig(matchIdx, newCfg);
 
+    // check for orphaned images
+    if (oldCfg.matchImgFilename != newCfg.matchImgFilename
+     && m_imageStore.isOrphaned(oldCfg)) {
+        emit sigMatchImagesOrphaned({oldCfg.matchImgFilename});
+    }
+}
+
+void PmCore::onMatchConfigEdited(size_t matchIdx, PmMatchConfig newCfg)
+{
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        if (matchIdx >= m_multiMatchConfig.size()) return;
+        m_pendingEdits[matchIdx] = newCfg;
+    }
+    if (!m_editTimer->isActive())
+        m_editTimer->start();
+}
+
+void PmCore::flushMatchConfigEdits()
+{
+    m_editTimer->stop();
+
+    std::map<size_t, PmMatchConfig> edits;
+    PmMultiMatchConfig mcfg;
     {
-        // check for orphaned images
         QMutexLocker locker(&m_matchConfigMutex);
-        if (oldCfg.wasDownloaded && oldCfg.matchImgFilename.size()
-         && oldCfg.matchImgFilename != newCfg.matchImgFilename
-         && !m_multiMatchConfig.containsImage(oldCfg.matchImgFilename, matchIdx)
-         && !m_matchPresets.containsImage(oldCfg.matchImgFilename)) {
-            emit sigMatchImagesOrphaned({oldCfg.matchImgFilename});
+        edits.swap(m_pendingEdits);
+        if (edits.empty()) return;
+        mcfg = m_multiMatchConfig;
+    }
+
+    // the batch goes into a copy, where edit indices stay valid; only then
+    // may entries move to satisfy the target order
+    std::vector<size_t> edited;
+    for (const auto &edit : edits) {
+        if (edit.first < mcfg.size() && mcfg[edit.first] != edit.second) {
+            mcfg[edit.first] = edit.second;
+            edited.push_back(edit.first);
+        }
+    }
+    if (edited.empty()) return;
+
+    bool reordered = false;
+    size_t selectIdx = m_selectedMatchIndex;
+    if (m_enforceReactionTypeOrder) {
+        for (size_t i = 0; i < edited.size(); ++i) {
+            size_t from = edited[i], to = from;
+            if (!moveToTargetOrder(mcfg, to)) continue;
+
+            // entries in between shift by one
+            for (size_t &idx : edited) {
+                if (idx == from)
+                    idx = to;
+                else if (from < to && idx > from && idx <= to)
+                    idx--;
+                else if (to < from && idx >= to && idx < from)
+                    idx++;
+            }
+            selectIdx = to;
+            reordered = true;
+        }
+    }
+
+    if (reordered) {
+        // the whole batch is activated in one step
+        activateMultiMatchConfig(mcfg);
+        onMatchConfigSelect(selectIdx);
+        return;
+    }
+
+    // nothing moves; the edited entries are updated in place
+    QSet<std::string> orphanedImages;
+    for (size_t idx : edited) {
+        PmMatchConfig oldCfg = matchConfig(idx);
+        activateMatchConfig(idx, mcfg[idx]);
+        if (oldCfg.matchImgFilename != mcfg[idx].matchImgFilename
+         && m_imageStore.isOrphaned(oldCfg)) {
+            orphanedImages.insert(oldCfg.matchImgFilename);
         }
     }
+    if (orphanedImages.size())
+        emit sigMatchImagesOrphaned(orphanedImages.values());
 }
 
 void PmCore::onMatchConfigInsert(size_t matchIndex, PmMatchConfig cfg)
 {
+    flushMatchConfigEdits();
+
     size_t oldSz = multiMatchConfigSize();
     if (matchIndex > oldSz) matchIndex = oldSz;
     size_t newSz = oldSz + 1;
-    
-    // notify other modules about the new size
-    emit sigMultiMatchConfigSizeChanged(newSz);
-    
-    // reconfigure the filter
-    if (m_runningEnabled) {
-        auto fr = activeFilterRef();
-        auto filterData = fr.filterData();
-        if (filterData) {
-            pm_resize_match_entries(filterData, newSz);
-        }
-    }
 
-    // reconfigure images
+    // entries below keep their filter state and images; they only move
+    m_decisionEngine.clearLingers();
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        m_multiMatchConfig.insert(
+            m_multiMatchConfig.begin() + int(matchIndex), cfg);
+        m_multiMatchHash.insertEntry(matchIndex, cfg);
+        m_imageStore.addRef(cfg.matchImgFilename);
+    }
+    compileMatchConfig();
     {
         QMutexLocker locker(&m_matchImagesMutex);
         m_matchImages.insert(m_matchImages.begin() + int(matchIndex), QImage());
     }
-    
-    // finish updating state and notifying
-    {
-        QMutexLocker locker(&m_matchConfigMutex);
-        m_multiMatchConfig.resize(newSz);
+    auto fr = activeFilterRef();
+    auto filterData = fr.filterData();
+    if (filterData) {
+        pm_insert_match_entry(filterData, matchIndex, &cfg.filterCfg);
+    }
+
+    // notify other modules
+    emit sigMultiMatchConfigSizeChanged(newSz);
+    for (size_t i = matchIndex; i < newSz; ++i) {
+        emit sigMatchConfigChanged(i, matchConfig(i));
     }
-    for (size_t i = newSz - 1; i > matchIndex; i--) {
-        activateMatchConfig(i, m_multiMatchConfig[i-1]);
+    for (size_t i = matchIndex + 1; i < newSz; ++i) {
+        announceMatchImage(i);
     }
-    activateMatchConfig(matchIndex, cfg);
-    
     emit sigActivePresetDirtyChanged();
+
+    if (m_runningEnabled && cfg.matchImgFilename.size()) {
+        loadImage(matchIndex);
+    }
+    m_forceSceneItemRefresh = true;
 }
 
 void PmCore::onMatchConfigRemove(size_t matchIndex)
 {
+    flushMatchConfigEdits();
+
     size_t oldSz = multiMatchConfigSize();
     if (matchIndex >= oldSz) return;
     size_t newSz = oldSz - 1;
 
-    // notify other modules
-    emit sigMultiMatchConfigSizeChanged(newSz);
-
-    // reconfigure the filter
-    auto fr = activeFilterRef();
-    auto filterData = fr.filterData();
-    if (filterData) {
-        pm_resize_match_entries(filterData, newSz);
-    }
-
+    // entries below keep their filter state and images; they only move
+    m_decisionEngine.clearLingers();
+    QList<std::string> orphanedImages;
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        PmMatchConfig removedCfg = m_multiMatchConfig[matchIndex];
+        m_multiMatchConfig.erase(
+            m_multiMatchConfig.begin() + int(matchIndex));
+        m_multiMatchHash.removeEntry(matchIndex);
+        m_imageStore.removeRef(removedCfg.matchImgFilename);
+        if (m_imageStore.isOrphaned(removedCfg))
+            orphanedImages = {removedCfg.matchImgFilename};
+    }
+    compileMatchConfig();
     {
-        // reconfigure images
         QMutexLocker locker(&m_matchImagesMutex);
         m_matchImages.erase(m_matchImages.begin() + int(matchIndex));
     }
-
-    // check for an orphaned image
-    QList<std::string> orphanedImages;
-    {
-        QMutexLocker locker(&m_matchConfigMutex);
-        const PmMatchConfig &cfg = m_multiMatchConfig[matchIndex];
-        if (cfg.wasDownloaded
-         && !m_multiMatchConfig.containsImage(cfg.matchImgFilename, matchIndex)
-         && !m_matchPresets.containsImage(cfg.matchImgFilename)) {
-            orphanedImages = {cfg.matchImgFilename};
-        }
+    auto fr = activeFilterRef();
+    auto filterData = fr.filterData();
+    if (filterData) {
+        pm_remove_match_entry(filterData, matchIndex);
     }
 
-    // finish updating state and notifying
+    // notify other modules
+    emit sigMultiMatchConfigSizeChanged(newSz);
     for (size_t i = matchIndex; i < newSz; ++i) {
-        onMatchConfigChanged(i, matchConfig(i + 1));
-    }
-    {
-        QMutexLocker locker(&m_matchConfigMutex);
-        m_multiMatchConfig.resize(newSz);
-        emit sigActivePresetDirtyChanged();
+        emit sigMatchConfigChanged(i, matchConfig(i));
+        announceMatchImage(i);
     }
+    emit sigActivePresetDirtyChanged();
+    m_forceSceneItemRefresh = true;
     onMatchConfigSelect(matchIndex);
 
     // notify about orphaned images
@@ -543,12 +923,11 @@ void PmCore::onMultiMatchConfigReset()
 
 void PmCore::onMatchConfigMoveUp(size_t matchIndex)
 {
+    flushMatchConfigEdits();
+
     if (matchIndex < 1 || matchIndex >= multiMatchConfigSize()) return;
 
-    PmMatchConfig oldAbove = matchConfig(matchIndex - 1);
-    PmMatchConfig oldBelow = matchConfig(matchIndex);
-    onMatchConfigChanged(matchIndex - 1, oldBelow);
-    onMatchConfigChanged(matchIndex, oldAbove);
+    swapMatchConfigs(matchIndex - 1, matchIndex);
 
     if (matchIndex == m_selectedMatchIndex)
         onMatchConfigSelect(matchIndex - 1);
@@ -556,17 +935,58 @@ void PmCore::onMatchConfigMoveUp(size_t matchIndex)
 
 void PmCore::onMatchConfigMoveDown(size_t matchIndex)
 {
-    if (matchIndex >= multiMatchConfigSize() - 1) return;
+    flushMatchConfigEdits();
 
-    PmMatchConfig oldAbove = matchConfig(matchIndex);
-    PmMatchConfig oldBelow = matchConfig(matchIndex + 1);
-    onMatchConfigChanged(matchIndex + 1, oldAbove);
-    onMatchConfigChanged(matchIndex, oldBelow);
+    if (matchIndex + 1 >= multiMatchConfigSize()) return;
+
+    swapMatchConfigs(matchIndex, matchIndex + 1);
 
     if (matchIndex == m_selectedMatchIndex)
         onMatchConfigSelect(matchIndex + 1);
 }
 
+void PmCore::swapMatchConfigs(size_t idxA, size_t idxB)
+{
+    // entries trade places along with their images and filter state
+    m_decisionEngine.clearLingers();
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        std::swap(m_multiMatchConfig[idxA], m_multiMatchConfig[idxB]);
+        m_multiMatchHash.swapEntries(idxA, idxB);
+    }
+    compileMatchConfig();
+    {
+        QMutexLocker locker(&m_matchImagesMutex);
+        std::swap(m_matchImages[idxA], m_matchImages[idxB]);
+    }
+    auto fr = activeFilterRef();
+    auto filterData = fr.filterData();
+    if (filterData) {
+        pm_swap_match_entries(filterData, idxA, idxB);
+    }
+
+    emit sigMatchConfigChanged(idxA, matchConfig(idxA));
+    emit sigMatchConfigChanged(idxB, matchConfig(idxB));
+    announceMatchImage(idxA);
+    announceMatchImage(idxB);
+    emit sigActivePresetDirtyChanged();
+    m_forceSceneItemRefresh = true;
+}
+
+void PmCore::announceMatchImage(size_t matchIdx)
+{
+    // a moved entry keeps its image; widgets only need to hear where it went
+    std::string filename = matchImgFilename(matchIdx);
+    if (filename.empty()) return;
+
+    QImage img = matchImage(matchIdx);
+    if (img.isNull()) {
+        emit sigMatchImageLoadFailed(matchIdx, filename);
+    } else {
+        emit sigMatchImageLoadSuccess(matchIdx, filename, img);
+    }
+}
+
 void PmCore::onMatchConfigSelect(size_t matchIndex)
 {   
     onCaptureStateChanged(PmCaptureState::Inactive);
@@ -576,9 +996,7 @@ void PmCore::onMatchConfigSelect(size_t matchIndex)
     auto fr = activeFilterRef();
     auto filterData = fr.filterData();
     if (filterData) {
-        fr.lockData();
-        filterData->selected_match_index = matchIndex;
-        fr.unlockData();
+        pm_select_match_entry(filterData, matchIndex);
     }
     
     if (!matchImageLoaded(matchIndex)) {
@@ -593,12 +1011,16 @@ void PmCore::onMatchConfigSelect(size_t matchIndex)
 
 void PmCore::onNoMatchReactionChanged(PmReaction noMatchReaction)
 {
-    QMutexLocker locker(&m_matchConfigMutex);
-    if (m_multiMatchConfig.noMatchReaction != noMatchReaction) {
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        if (m_multiMatchConfig.noMatchReaction == noMatchReaction)
+            return;
         m_multiMatchConfig.noMatchReaction = noMatchReaction;
+        m_multiMatchHash.setNoMatchReaction(noMatchReaction);
         emit sigNoMatchReactionChanged(m_multiMatchConfig.noMatchReaction);
         emit sigActivePresetDirtyChanged();
     }
+    compileMatchConfig();
 }
 
 void PmCore::onPreviewConfigChanged(PmPreviewConfig cfg)
@@ -643,65 +1065,119 @@ std::string PmCore::activeMatchPresetName() const
 bool PmCore::matchPresetExists(const std::string& name) const
 {
     QMutexLocker locker(&m_matchConfigMutex);
-    return m_matchPresets.find(name) != m_matchPresets.end();
+    return m_matchPresets.contains(name) || m_savedPresets.contains(name);
 }
 
 PmMultiMatchConfig PmCore::matchPresetByName(const std::string& name) const
 {
     QMutexLocker locker(&m_matchConfigMutex);
-    return m_matchPresets.value(name, PmMultiMatchConfig());
+    const PmMultiMatchConfig *preset = findMatchPreset(name);
+    return preset ? *preset : PmMultiMatchConfig();
 }
 
 size_t PmCore::matchPresetSize(const std::string& name) const
 {
     QMutexLocker locker(&m_matchConfigMutex);
     auto find = m_matchPresets.find(name);
-    if (find == m_matchPresets.end()) {
-        return 0;
-    } else {
+    if (find != m_matchPresets.end())
         return find->size();
-    }
+
+    auto findSaved = m_savedPresets.find(name);
+    if (findSaved == m_savedPresets.end())
+        return 0;
+
+    // counting entries doesn't need the preset parsed
+    obs_data_array_t *entriesArray
+        = obs_data_get_array(*findSaved, "entries");
+    size_t count = obs_data_array_count(entriesArray);
+    obs_data_array_release(entriesArray);
+    return count;
 }
 
 QList<std::string> PmCore::matchPresetNames() const
 {
     QMutexLocker locker(&m_matchConfigMutex);
-    return m_matchPresets.keys();
+    QList<std::string> ret = m_matchPresets.keys();
+    for (auto it = m_savedPresets.begin(); it != m_savedPresets.end(); ++it) {
+        if (!m_matchPresets.contains(it.key()))
+            ret.push_back(it.key());
+    }
+    return ret;
+}
+
+const PmMultiMatchConfig *PmCore::findMatchPreset(
+    const std::string &name) const
+{
+    QMutexLocker locker(&m_matchConfigMutex);
+    auto find = m_matchPresets.find(name);
+    if (find == m_matchPresets.end()) {
+        auto findSaved = m_savedPresets.find(name);
+        if (findSaved == m_savedPresets.end())
+            return nullptr;
+        find = m_matchPresets.insert(name, PmMultiMatchConfig(*findSaved));
+    }
+    return &(*find);
+}
+
+void PmCore::storeMatchPreset(
+    const std::string &name, const PmMultiMatchConfig &mcfg)
+{
+    QMutexLocker locker(&m_matchConfigMutex);
+    m_matchPresets[name] = mcfg;
+    m_savedPresets.remove(name);
+    m_presetHashes.remove(name);
+}
+
+void PmCore::materializeMatchPresets(const QList<std::string> &names) const
+{
+    QMutexLocker locker(&m_matchConfigMutex);
+    for (const auto &name : names) {
+        findMatchPreset(name);
+    }
 }
 
 bool PmCore::matchConfigDirty() const
 {
     QMutexLocker locker(&m_matchConfigMutex);
     if (m_activeMatchPreset.empty()) {
-        for (size_t i = 0; i < m_multiMatchConfig.size(); ++i) {
-            if (m_multiMatchConfig[i] != PmMatchConfig()) {
-                return true;
-            }
-        }
-        return m_multiMatchConfig.noMatchReaction != PmReaction();
+        return !m_multiMatchHash.isDefault();
     } else {
-        const PmMultiMatchConfig& presetCfg 
-            = m_matchPresets[m_activeMatchPreset];
-        return presetCfg != m_multiMatchConfig;
+        // hashes are compared instead of walking every reaction and action
+        return matchPresetHash(m_activeMatchPreset)
+            != m_multiMatchHash.value();
+    }
+}
+
+size_t PmCore::matchPresetHash(const std::string &name) const
+{
+    QMutexLocker locker(&m_matchConfigMutex);
+    auto find = m_presetHashes.find(name);
+    if (find == m_presetHashes.end()) {
+        const PmMultiMatchConfig *preset = findMatchPreset(name);
+        size_t hash = PmMultiMatchHash(
+            preset ? *preset : PmMultiMatchConfig()).value();
+        find = m_presetHashes.insert(name, hash);
     }
+    return *find;
 }
 
 void PmCore::onMatchPresetSave(std::string name)
 {
+    flushMatchConfigEdits();
+
     bool isNew = !matchPresetExists(name);
     QSet<std::string> orphanedImages;
     {
         QMutexLocker locker(&m_matchConfigMutex);
 
-        PmMatchPresets newPresets = m_matchPresets;
-        newPresets[name] = m_multiMatchConfig;
-
-        if (m_matchPresets.contains(name)) {
-            PmMultiMatchConfig oldMcfg = m_matchPresets[name];
-            orphanedImages = newPresets.orphanedImages(oldMcfg);
-        }
-
-        m_matchPresets = newPresets;
+        const PmMultiMatchConfig *oldPreset = findMatchPreset(name);
+        PmMultiMatchConfig oldMcfg
+            = oldPreset ? *oldPreset : PmMultiMatchConfig();
+        storeMatchPreset(name, m_multiMatchConfig);
+        m_presetHashes[name] = m_multiMatchHash.value();
+        m_imageStore.addRefs(m_multiMatchConfig);
+        m_imageStore.removeRefs(oldMcfg);
+        orphanedImages = m_imageStore.orphanedImages(oldMcfg);
     }
     if (isNew) {
         emit sigAvailablePresetsChanged();
@@ -724,7 +1200,8 @@ void PmCore::onMatchPresetSelect(std::string name)
         if (m_activeMatchPreset == name) return;
         m_activeMatchPreset = name;
 
-        multiConfig = name.size() ? m_matchPresets[name] : PmMultiMatchConfig();
+        const PmMultiMatchConfig *preset = findMatchPreset(name);
+        multiConfig = preset ? *preset : PmMultiMatchConfig();
     }
     emit sigActivePresetChanged();
     activateMultiMatchConfig(multiConfig);
@@ -736,24 +1213,20 @@ void PmCore::onMatchPresetRemove(std::string name)
     QSet<std::string> orphanedImages;
     {
         QMutexLocker locker(&m_matchConfigMutex);
-        if (m_matchPresets.empty()) return;
-
-        // stage reduced presets
-        PmMatchPresets newPresets = m_matchPresets;
-        newPresets.remove(name);
+        if (!findMatchPreset(name)) return;
 
-        // check for orphaned images
-        PmMultiMatchConfig mcfgRemoved = m_matchPresets[name];
-        auto orphanedImages = newPresets.orphanedImages(
-            mcfgRemoved, &m_multiMatchConfig);
+        // remove the preset and check for orphaned images
+        PmMultiMatchConfig mcfgRemoved = m_matchPresets.take(name);
+        m_savedPresets.remove(name);
+        m_presetHashes.remove(name);
+        m_imageStore.removeRefs(mcfgRemoved);
+        orphanedImages = m_imageStore.orphanedImages(mcfgRemoved);
 
         // pick a new selection, when needed
-        if (m_activeMatchPreset == name && newPresets.size()) {
-            selOther = newPresets.keys().first();
+        QList<std::string> names = matchPresetNames();
+        if (m_activeMatchPreset == name && names.size()) {
+            selOther = names.first();
         }
-
-        // finalize data
-        m_matchPresets = newPresets;
     }
 
     emit sigAvailablePresetsChanged();
@@ -774,7 +1247,14 @@ void PmCore::onMatchPresetExport(
     std::string filename,  QList<std::string> selectedPresets)
 {
     try {
-        m_matchPresets.exportXml(filename, selectedPresets);
+        QMutexLocker locker(&m_matchConfigMutex);
+        materializeMatchPresets(selectedPresets);
+        QString suffix = QFileInfo(filename.data()).suffix();
+        if (suffix == PmPresetPack::k_extension) {
+            PmPresetPack::write(filename, m_matchPresets, selectedPresets);
+        } else {
+            m_matchPresets.exportXml(filename, selectedPresets);
+        }
     } catch (const std::exception &e) {
         blog(LOG_ERROR, "Preset Export Failed: %s", e.what());
         emit sigShowException(
@@ -790,7 +1270,36 @@ void PmCore::onMatchPresetExport(
 void PmCore::onMatchPresetsImport(std::string filename)
 {
     try {
-        PmMatchPresets impPresets(filename);
+        if (!PmPresetPack::isPack(filename)) {
+            PmMatchPresets impPresets(filename);
+            emit sigPresetsImportAvailable(impPresets);
+            return;
+        }
+
+        // pack images go where downloaded presets keep theirs; they are
+        // written out only for the presets that actually get added
+        auto pack = std::make_shared<PmPresetPack>(filename);
+        QFileInfo packInfo(filename.data());
+        std::ostringstream oss;
+        oss << std::hex << qHash(packInfo.absoluteFilePath());
+        char *storePath = os_get_config_path_ptr(
+            "obs-studio/plugin_config/PixelMatchSwitcher/presets/");
+        std::string packDir = std::string(storePath)
+            + packInfo.completeBaseName().toUtf8().data()
+            + '_' + oss.str() + '/';
+        bfree(storePath);
+
+        PmMatchPresets impPresets = pack->presets();
+        for (auto &mcfg : impPresets) {
+            for (PmMatchConfig &cfg : mcfg) {
+                if (pack->containsImage(cfg.matchImgFilename)) {
+                    cfg.matchImgFilename = packDir + cfg.matchImgFilename;
+                    cfg.wasDownloaded = true;
+                }
+            }
+        }
+        m_importPack = pack;
+        m_importPackDir = packDir;
         emit sigPresetsImportAvailable(impPresets);
     } catch (const std::exception &e) {
         blog(LOG_ERROR, "Preset Import Failed: %s", e.what());
@@ -807,7 +1316,15 @@ void PmCore::onMatchPresetsImport(std::string filename)
 void PmCore::onMatchPresetsAppend(PmMatchPresets newPresets)
 {
     for (const auto &name : newPresets.keys()) {
-        m_matchPresets.insert(name, newPresets[name]);
+        extractPackImages(newPresets[name]);
+        {
+            QMutexLocker locker(&m_matchConfigMutex);
+            const PmMultiMatchConfig *oldPreset = findMatchPreset(name);
+            if (oldPreset)
+                m_imageStore.removeRefs(*oldPreset);
+            m_imageStore.addRefs(newPresets[name]);
+            storeMatchPreset(name, newPresets[name]);
+        }
         if (name == activeMatchPresetName())
             onMatchPresetActiveRevert();
     }
@@ -816,13 +1333,51 @@ void PmCore::onMatchPresetsAppend(PmMatchPresets newPresets)
     obs_frontend_save();
 }
 
-void PmCore::onRunningEnabledChanged(bool enable)
+void PmCore::onMatchPresetsImportFinished()
 {
-    if (m_runningEnabled != enable) {
-        if (enable) {
-            activate();
-        } else {
-            deactivate();
+    // unmaps the pack, so the file isn't held open (and locked, on Windows)
+    m_importPack.reset();
+    m_importPackDir.clear();
+}
+
+void PmCore::extractPackImages(const PmMultiMatchConfig &mcfg)
+{
+    if (!m_importPack)
+        return;
+
+    const std::string &packDir = m_importPackDir;
+    for (const PmMatchConfig &cfg : mcfg) {
+        const std::string &filename = cfg.matchImgFilename;
+        if (filename.compare(0, packDir.size(), packDir) != 0
+         || QFile::exists(filename.data()))
+            continue;
+
+        os_mkdirs(packDir.data());
+        std::string imageName = filename.substr(packDir.size());
+
+        // the pack refuses names with path parts; this guards the
+        // destination itself, in case the folder was tampered with
+        QString destDir = QFileInfo(filename.data()).absolutePath();
+        if (QFileInfo(destDir).canonicalFilePath()
+                != QFileInfo(packDir.data()).canonicalFilePath()) {
+            blog(LOG_WARNING, "Refusing to extract %s outside of %s",
+                 imageName.data(), packDir.data());
+            continue;
+        }
+        if (!m_importPack->extractImage(imageName, filename)) {
+            blog(LOG_WARNING, "Unable to extract %s from preset pack",
+                 imageName.data());
+        }
+    }
+}
+
+void PmCore::onRunningEnabledChanged(bool enable)
+{
+    if (m_runningEnabled != enable) {
+        if (enable) {
+            activate();
+        } else {
+            deactivate();
         }
         sigRunningEnabledChanged(enable);
     }
@@ -864,12 +1419,7 @@ void PmCore::onCaptureStateChanged(PmCaptureState state, int x, int y)
         filter = activeFilterRef();
         filterData = filter.filterData();
         if (filterData) {
-            filter.lockData();
-            filterData->select_left = 0;
-            filterData->select_bottom = 0;
-            filterData->select_right = 0;
-            filterData->select_top = 0;
-            filter.unlockData();
+            pm_set_select_region(filterData, 0, 0, 0, 0);
         }
         break;
     case PmCaptureState::Activated:
@@ -884,20 +1434,15 @@ void PmCore::onCaptureStateChanged(PmCaptureState state, int x, int y)
             filter = activeFilterRef();
             filterData = filter.filterData();
             if (filterData) {
-                filter.lockData();
-                x = std::min(x, int(filterData->base_width - 1));
-                y = std::min(y, int(filterData->base_height - 1));
+                x = std::min(x, int(pm_get_base_width(filterData)) - 1);
+                y = std::min(y, int(pm_get_base_height(filterData)) - 1);
                 m_captureEndX = x;
                 m_captureEndY = y;
-                filterData->select_left = (uint32_t)(
-                    std::min(m_captureStartX, m_captureEndX));
-                filterData->select_bottom = (uint32_t)(
-                    std::min(m_captureStartY, m_captureEndY));
-                filterData->select_right = (uint32_t)(
-                    std::max(m_captureStartX, m_captureEndX));
-                filterData->select_top = (uint32_t)(
-                    std::max(m_captureStartY, m_captureEndY));
-                filter.unlockData();
+                pm_set_select_region(filterData,
+                    (uint32_t)(std::min(m_captureStartX, m_captureEndX)),
+                    (uint32_t)(std::min(m_captureStartY, m_captureEndY)),
+                    (uint32_t)(std::max(m_captureStartX, m_captureEndX)),
+                    (uint32_t)(std::max(m_captureStartY, m_captureEndY)));
             }
         }
         break;
@@ -905,21 +1450,17 @@ void PmCore::onCaptureStateChanged(PmCaptureState state, int x, int y)
         filter = activeFilterRef();
         filterData = filter.filterData();
         if (filterData) {
-            filter.lockData();
             if (prevState == PmCaptureState::Automask)
-                filterData->filter_mode = PM_MASK_END;
+                pm_set_filter_mode(filterData, PM_MASK_END);
             else
-                filterData->filter_mode = PM_SNAPSHOT;
-            filter.unlockData();
+                pm_set_filter_mode(filterData, PM_SNAPSHOT);
         }
         break;
     case PmCaptureState::Automask:
         filter = activeFilterRef();
         filterData = filter.filterData();
         if (filterData) {
-            filter.lockData();
-            filterData->filter_mode = PM_MASK_BEGIN;
-            filter.unlockData();
+            pm_set_filter_mode(filterData, PM_MASK_BEGIN);
         }
     }
 
@@ -1061,10 +1602,12 @@ void PmCore::scanScenes()
     obs_frontend_get_scenes(&scenesInput);
 
     PmSceneScanInfo scanInfo;
+    scanInfo.core = this;
 
     for (size_t i = 0; i < scenesInput.sources.num; ++i) {
         auto &sceneSrc = scenesInput.sources.array[i];
         auto sceneName = obs_source_get_name(sceneSrc);
+        connectSourceSignals(sceneSrc, this);
 
         // map scene names to scene refs
         obs_weak_source_t *sceneWs = obs_source_get_weak_source(sceneSrc);
@@ -1132,13 +1675,15 @@ void PmCore::scanScenes()
     obs_enum_sources(
         [](void *data, obs_source_t* source) -> bool
         {
+            PmSceneScanInfo *scanInfo = (PmSceneScanInfo *)data;
+            connectSourceSignals(source, scanInfo->core);
+
             uint32_t flags = obs_source_get_output_flags(source);
             if ((flags & OBS_SOURCE_AUDIO) != 0) {
                 std::string audioName = obs_source_get_name(source);
                 obs_weak_source_t *audioWs = obs_source_get_weak_source(source);
                 OBSWeakSource audioWsWs(audioWs);
                 obs_weak_source_release(audioWs);
-                PmSceneScanInfo *scanInfo = (PmSceneScanInfo *)data;
                 scanInfo->audioSources.insert(audioName, {audioWsWs});
             }
             return true;
@@ -1149,6 +1694,7 @@ void PmCore::scanScenes()
 
     bool scenesChanged = false;
     bool sceneItemsChanged = false;
+    bool filtersChanged = false;
     bool audioSourcesChanged = false;
     QSet<std::string> oldSceneNames;
     QSet<std::string> oldSceneItemNames;
@@ -1166,7 +1712,7 @@ void PmCore::scanScenes()
         }
         if (m_filters != scanInfo.filters) {
             oldFilterNames = m_filters.sourceNames();
-            sceneItemsChanged = true;
+            filtersChanged = true;
         }
         if (m_audioSources != scanInfo.audioSources) {
             oldAudioNames = m_audioSources.sourceNames();
@@ -1174,128 +1720,45 @@ void PmCore::scanScenes()
         }
     }
 
-    if (scenesChanged || sceneItemsChanged) {
-        emit sigScenesChanged(scanInfo.scenes.keys(), scanInfo.sceneItems.keys());
-    }
-    if (audioSourcesChanged) {
-        emit sigAudioSourcesChanged(scanInfo.audioSources.keys());
-    }
-
-    // adjust for scene changes
-    if (scenesChanged) {
-        QMutexLocker locker(&m_scenesMutex);
-        size_t cfgSize = multiMatchConfigSize();
-        for (const std::string& oldSceneName : oldSceneNames) {
-            if (!scanInfo.scenes.contains(oldSceneName)) {
-                auto ws = m_scenes[oldSceneName];
-                std::string newSceneName = scanInfo.scenes.key(ws);
-                if (m_multiMatchConfig.noMatchReaction.hasSceneAction()) {
-                    auto noMatchReaction = m_multiMatchConfig.noMatchReaction;
-                    if (noMatchReaction.renameElement(
-                        PmActionType::Scene, oldSceneName, newSceneName)) {
-                            onNoMatchReactionChanged(noMatchReaction);
-                    }
-                }
-                for (size_t i = 0; i < cfgSize; i++) {
-                    if (hasSceneAction(i)) {
-                        PmMatchConfig cfg = m_multiMatchConfig[i];
-                        if (cfg.reaction.renameElement(
-                            PmActionType::Scene, oldSceneName, newSceneName)) {
-                            onMatchConfigChanged(i, cfg);
-                        }
-                    }
-                }
-            }
+    // only the differences are sent to the UI
+    if (scenesChanged || sceneItemsChanged || filtersChanged
+     || audioSourcesChanged) {
+        PmSceneGraphDelta delta;
+        delta.scenesChanged = scenesChanged;
+        delta.sceneItemsChanged = sceneItemsChanged || filtersChanged;
+        delta.audioSourcesChanged = audioSourcesChanged;
+        if (scenesChanged) {
+            nameDelta(oldSceneNames, scanInfo.scenes.sourceNames(),
+                      delta.addedScenes, delta.removedScenes);
         }
-    }
-
-    // adjust for scene item and filter changes
-    if (sceneItemsChanged) {
-        QMutexLocker locker(&m_scenesMutex);
-        size_t cfgSize = multiMatchConfigSize();
-
-        // scene items
-        auto newSiNames = scanInfo.sceneItems.keys();
-        for (const std::string& oldSiName : oldSceneItemNames) {
-            if (!newSiNames.contains(oldSiName)) {
-                auto src = m_sceneItems[oldSiName];
-                std::string newSiName = scanInfo.sceneItems.key(src);
-                if (m_multiMatchConfig.noMatchReaction.hasAction(
-                        PmActionType::SceneItem)) {
-                    auto noMatchReaction = m_multiMatchConfig.noMatchReaction;
-                    if (noMatchReaction.renameElement(
-                        PmActionType::SceneItem, oldSiName, newSiName)) {
-                            onNoMatchReactionChanged(noMatchReaction);
-                    }
-                    for (size_t i = 0; i < cfgSize; i++) {
-                        if (hasSceneAction(i)) {
-                            PmMatchConfig cfg = m_multiMatchConfig[i];
-                            if (cfg.reaction.renameElement(
-                                PmActionType::SceneItem, oldSiName, newSiName)) {
-                                onMatchConfigChanged(i, cfg);
-                            }
-                        }
-                    }
-                }
-            }
+        if (sceneItemsChanged) {
+            nameDelta(oldSceneItemNames, scanInfo.sceneItems.sceneItemNames(),
+                      delta.addedSceneItems, delta.removedSceneItems);
         }
-
-        // filters
-        auto newFiNames = scanInfo.filters.keys();
-        for (const std::string& oldFiName : oldFilterNames) {
-            if (!newFiNames.contains(oldFiName)) {
-                auto ws = m_filters[oldFiName];
-                std::string newFiName = scanInfo.filters.key(ws);
-                if (m_multiMatchConfig.noMatchReaction.hasAction(
-                        PmActionType::SceneItem)) {
-                    auto noMatchReaction = m_multiMatchConfig.noMatchReaction;
-                    if (noMatchReaction.renameElement(
-                        PmActionType::SceneItem, oldFiName, newFiName)) {
-                            onNoMatchReactionChanged(noMatchReaction);
-                    }
-                    for (size_t i = 0; i < cfgSize; i++) {
-                        if (hasSceneAction(i)) {
-                            PmMatchConfig cfg = m_multiMatchConfig[i];
-                            if (cfg.reaction.renameElement(
-                                PmActionType::SceneItem, oldFiName, newFiName)) {
-                                onMatchConfigChanged(i, cfg);
-                            }
-                        }
-                    }
-                }
-            }
+        if (filtersChanged) {
+            nameDelta(oldFilterNames, scanInfo.filters.sourceNames(),
+                      delta.addedFilters, delta.removedFilters);
         }
+        if (audioSourcesChanged) {
+            nameDelta(oldAudioNames, scanInfo.audioSources.sourceNames(),
+                      delta.addedAudioSources, delta.removedAudioSources);
+        }
+        emit sigSceneGraphChanged(delta);
     }
+    sceneItemsChanged |= filtersChanged;
 
-    if (audioSourcesChanged) {
+    // names that disappeared are looked up by identity among the new ones
+    PmRenameMap sceneRenames, siRenames, fiRenames, audioRenames;
+    {
         QMutexLocker locker(&m_scenesMutex);
-        size_t cfgSize = multiMatchConfigSize();
-        for (const std::string &oldAudioName : oldAudioNames) {
-            if (!scanInfo.audioSources.contains(oldAudioName)) {
-                auto ws = m_audioSources[oldAudioName];
-
-                std::string newAudioName = scanInfo.audioSources.key(ws);
-                if (m_multiMatchConfig.noMatchReaction.hasAction(
-                        PmActionType::ToggleMute)) {
-                    auto noMatchReaction =
-                        m_multiMatchConfig.noMatchReaction;
-                    if (noMatchReaction.renameElement(
-                            PmActionType::ToggleMute, 
-                            oldAudioName, newAudioName)) {
-                        onNoMatchReactionChanged(noMatchReaction);
-                    }
-                }
-                for (size_t i = 0; i < cfgSize; i++) {
-                    if (hasAction(i, PmActionType::ToggleMute)) {
-                        PmMatchConfig cfg = m_multiMatchConfig[i];
-                        if (cfg.reaction.renameElement(PmActionType::ToggleMute,
-                                oldAudioName, newAudioName)) {
-                            onMatchConfigChanged(i, cfg);
-                        }
-                    }
-                }
-            }
-        }
+        if (scenesChanged)
+            sceneRenames = findRenames(m_scenes, scanInfo.scenes);
+        if (sceneItemsChanged)
+            siRenames = findRenames(m_sceneItems, scanInfo.sceneItems);
+        if (filtersChanged)
+            fiRenames = findRenames(m_filters, scanInfo.filters);
+        if (audioSourcesChanged)
+            audioRenames = findRenames(m_audioSources, scanInfo.audioSources);
     }
 
     // save state
@@ -1307,6 +1770,98 @@ void PmCore::scanScenes()
         m_filters = scanInfo.filters;
         m_audioSources = scanInfo.audioSources;
     }
+
+    if (sceneRenames.size() || siRenames.size() || fiRenames.size()
+     || audioRenames.size()) {
+        renameReactionElements(sceneRenames, siRenames, fiRenames,
+                               audioRenames);
+    }
+
+    // reactions are resolved against the new scene graph
+    if (scenesChanged || sceneItemsChanged || audioSourcesChanged)
+        compileMatchConfig();
+}
+
+void PmCore::renameReactionElements(const PmRenameMap &sceneRenames,
+    const PmRenameMap &siRenames, const PmRenameMap &fiRenames,
+    const PmRenameMap &audioRenames)
+{
+    auto rename = [&](PmReaction &reaction) -> bool {
+        bool ret = reaction.renameElements(PmActionType::Scene, sceneRenames);
+        ret |= reaction.renameElements(PmActionType::SceneItem, siRenames);
+        ret |= reaction.renameElements(PmActionType::Filter, fiRenames);
+        ret |= reaction.renameElements(PmActionType::ToggleMute, audioRenames);
+        return ret;
+    };
+
+    // all reactions are patched in one go; only reactions change, so the
+    // filter and match images are left alone. caller recompiles the config
+    std::vector<std::pair<size_t, PmMatchConfig>> changedCfgs;
+    bool noMatchChanged;
+    PmReaction noMatchReaction;
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        for (size_t i = 0; i < m_multiMatchConfig.size(); ++i) {
+            if (rename(m_multiMatchConfig[i].reaction)) {
+                changedCfgs.emplace_back(i, m_multiMatchConfig[i]);
+                m_multiMatchHash.setEntry(i, m_multiMatchConfig[i]);
+            }
+        }
+        noMatchChanged = rename(m_multiMatchConfig.noMatchReaction);
+        noMatchReaction = m_multiMatchConfig.noMatchReaction;
+        if (noMatchChanged)
+            m_multiMatchHash.setNoMatchReaction(noMatchReaction);
+    }
+    if (changedCfgs.empty() && !noMatchChanged)
+        return;
+
+    for (const auto &changed : changedCfgs) {
+        emit sigMatchConfigChanged(changed.first, changed.second);
+    }
+    if (noMatchChanged)
+        emit sigNoMatchReactionChanged(noMatchReaction);
+    emit sigActivePresetDirtyChanged();
+}
+
+void PmCore::onSceneGraphSignal(void *data, calldata_t *cd)
+{
+    // may be called from any thread; the next periodic update rescans
+    static_cast<PmCore *>(data)->m_sceneGraphDirty = true;
+    UNUSED_PARAMETER(cd);
+}
+
+void PmCore::onSourceCreated(void *data, calldata_t *cd)
+{
+    auto source = static_cast<obs_source_t *>(calldata_ptr(cd, "source"));
+    connectSourceSignals(source, static_cast<PmCore *>(data));
+    static_cast<PmCore *>(data)->m_sceneGraphDirty = true;
+}
+
+void PmCore::connectSourceSignals(obs_source_t *source, PmCore *core)
+{
+    // connecting again is a no-op in OBS, so scans can reconnect freely
+    if (!source)
+        return;
+    obs_source_type type = obs_source_get_type(source);
+    if (type != OBS_SOURCE_TYPE_INPUT && type != OBS_SOURCE_TYPE_SCENE)
+        return;
+
+    signal_handler_t *sh = obs_source_get_signal_handler(source);
+    signal_handler_connect(sh, "filter_add", onSceneGraphSignal, core);
+    signal_handler_connect(sh, "filter_remove", onSceneGraphSignal, core);
+    if (type == OBS_SOURCE_TYPE_SCENE) {
+        signal_handler_connect(sh, "item_add", onSceneGraphSignal, core);
+        signal_handler_connect(sh, "item_remove", onSceneGraphSignal, core);
+    }
+}
+
+void PmCore::disconnectSourceSignals(obs_source_t *source, PmCore *core)
+{
+    signal_handler_t *sh = obs_source_get_signal_handler(source);
+    signal_handler_disconnect(sh, "filter_add", onSceneGraphSignal, core);
+    signal_handler_disconnect(sh, "filter_remove", onSceneGraphSignal, core);
+    signal_handler_disconnect(sh, "item_add", onSceneGraphSignal, core);
+    signal_handler_disconnect(sh, "item_remove", onSceneGraphSignal, core);
 }
 
 void PmCore::updateActiveFilter(
@@ -1322,10 +1877,7 @@ void PmCore::updateActiveFilter(
         } else {
             auto data = m_activeFilter.filterData();
             if (data) {
-                m_activeFilter.lockData();
-                data->on_frame_processed = nullptr;
-                data->on_match_image_captured = nullptr;
-                m_activeFilter.unlockData();
+                pm_set_filter_callbacks(data, nullptr, nullptr);
                 pm_resize_match_entries(data, 0);
             }
             m_activeFilter.reset();
@@ -1337,17 +1889,21 @@ void PmCore::updateActiveFilter(
         m_activeFilter.setFilter(newFilter);
         auto data = m_activeFilter.filterData();
         if (data) {
-            size_t cfgSize = multiMatchConfigSize();
-            m_activeFilter.lockData();
-            data->on_frame_processed = on_frame_processed;
-            data->on_match_image_captured = on_match_image_captured;
+            std::vector<pm_match_entry_config> filterCfgs;
+            {
+                QMutexLocker locker(&m_matchConfigMutex);
+                filterCfgs.reserve(m_multiMatchConfig.size());
+                for (const auto &cfg : m_multiMatchConfig) {
+                    filterCfgs.push_back(cfg.filterCfg);
+                }
+            }
+            size_t cfgSize = filterCfgs.size();
             data->on_settings_button_released = on_settings_button_released;
-            data->selected_match_index = m_selectedMatchIndex;
-            m_activeFilter.unlockData();
-            pm_resize_match_entries(data, cfgSize);
+            pm_set_filter_callbacks(
+                data, on_frame_processed, on_match_image_captured);
+            pm_select_match_entry(data, m_selectedMatchIndex);
+            pm_set_match_entry_configs(data, cfgSize, filterCfgs.data());
             for (size_t i = 0; i < cfgSize; ++i) {
-                auto cfg = matchConfig(i).filterCfg;
-                pm_supply_match_entry_config(data, i, &cfg);
                 supplyImageToFilter(data, i, matchImage(i));
             }
         }
@@ -1364,8 +1920,7 @@ void PmCore::activateMatchConfig(
     QSet<std::string>* orphanedImages)
 {
     // clean linger delay, for safety
-    m_sceneLingerQueue.removeAll();
-    m_lingerList.removeAll();
+    m_decisionEngine.clearLingers();
 
     auto oldCfg = matchConfig(matchIdx);
 
@@ -1376,8 +1931,12 @@ void PmCore::activateMatchConfig(
     {
         QMutexLocker locker(&m_matchConfigMutex);
         m_multiMatchConfig[matchIdx] = newCfg;
+        m_multiMatchHash.setEntry(matchIdx, newCfg);
+        m_imageStore.addRef(newCfg.matchImgFilename);
+        m_imageStore.removeRef(oldCfg.matchImgFilename);
         emit sigActivePresetDirtyChanged();
     }
+    compileMatchConfig();
 
     // update filter
     auto fr = activeFilterRef();
@@ -1390,10 +1949,22 @@ void PmCore::activateMatchConfig(
     // update images
     if (m_runningEnabled) {
         if (newCfg.matchImgFilename != oldCfg.matchImgFilename) {
+            // the old image is gone while the new one is decoded
+            {
+                QMutexLocker locker(&m_matchImagesMutex);
+                m_matchImages[matchIdx] = QImage();
+            }
+            if (filterData)
+                supplyImageToFilter(filterData, matchIdx, QImage());
             loadImage(matchIdx);
+        } else if (filterData
+                && (newCfg.filterCfg.mask_alpha != oldCfg.filterCfg.mask_alpha
+                 || !vec3_eq(&newCfg.filterCfg.mask_color,
+                             &oldCfg.filterCfg.mask_color))) {
+            // masking rules changed; region of active pixels is different
+            supplyImageToFilter(filterData, matchIdx, matchImage(matchIdx));
         }
-        if (orphanedImages && oldCfg.matchImgFilename.size()
-         && oldCfg.wasDownloaded) {
+        if (orphanedImages && m_imageStore.isOrphaned(oldCfg)) {
             orphanedImages->insert(oldCfg.matchImgFilename);
         }
     }
@@ -1404,13 +1975,64 @@ void PmCore::activateMatchConfig(
 
 void PmCore::loadImage(size_t matchIdx)
 {
-    auto cfg = matchConfig(matchIdx);
-    const char* filename = cfg.matchImgFilename.data();
-    QImage img(filename);
+    std::string filename = matchImgFilename(matchIdx);
+    if (filename.empty()) {
+        onImageDecoded(matchIdx, filename, QImage());
+    } else {
+        requestImage(filename);
+    }
+}
+
+void PmCore::requestImage(const std::string &filename)
+{
+    // decoding happens on the image pool; every entry using the file picks
+    // up the image when it arrives, and a newer request supersedes an older
+    auto find = m_imageLoads.find(filename);
+    if (find != m_imageLoads.end())
+        find->future.cancel();
+
+    PmImageLoad load;
+    load.serial = ++m_imageLoadSerial;
+    load.future = m_imageIo.decode(filename);
+    m_imageLoads[filename] = load;
+
+    uint64_t serial = load.serial;
+    load.future.then(this, [this, filename, serial](PmDecodedImage decoded) {
+        auto find = m_imageLoads.find(filename);
+        if (find == m_imageLoads.end() || find->serial != serial)
+            return;
+        m_imageLoads.erase(find);
+
+        // identical pixels from another file are already in memory
+        QImage img = m_imageStore.share(decoded);
+
+        std::vector<size_t> indices;
+        {
+            QMutexLocker locker(&m_matchConfigMutex);
+            for (size_t i = 0; i < m_multiMatchConfig.size(); ++i) {
+                if (m_multiMatchConfig[i].matchImgFilename == filename)
+                    indices.push_back(i);
+            }
+        }
+        for (size_t matchIdx : indices) {
+            onImageDecoded(matchIdx, filename, img);
+        }
+    });
+}
+
+void PmCore::cancelImageLoads()
+{
+    for (auto &load : m_imageLoads) {
+        load.future.cancel();
+    }
+    m_imageLoads.clear();
+}
+
+void PmCore::onImageDecoded(
+    size_t matchIdx, const std::string &filename, const QImage &img)
+{
     if (img.isNull()) {
-        blog(LOG_WARNING, "Unable to open filename: %s", filename);
         emit sigMatchImageLoadFailed(matchIdx, filename);
-        img = QImage();
 
         if (matchIdx == m_selectedMatchIndex) {
             auto previewCfg = previewConfig();
@@ -1419,17 +2041,8 @@ void PmCore::loadImage(size_t matchIdx)
                 onPreviewConfigChanged(previewCfg);
             }
         }
-    }
-    else {
-        img = img.convertToFormat(QImage::Format_ARGB32);
-        if (img.isNull()) {
-            blog(LOG_WARNING, "Image conversion failed: %s", filename);
-            emit sigMatchImageLoadFailed(matchIdx, filename);
-            img = QImage();
-        }
-        else {
-            emit sigMatchImageLoadSuccess(matchIdx, filename, img);
-        }
+    } else {
+        emit sigMatchImageLoadSuccess(matchIdx, filename, img);
     }
     {
         QMutexLocker locker(&m_matchImagesMutex);
@@ -1444,39 +2057,82 @@ void PmCore::loadImage(size_t matchIdx)
     }
 }
 
-void PmCore::resetMultiMatchConfig(const PmMultiMatchConfig *newCfg)
+void PmCore::resetMultiMatchConfig()
 {
-    // cheeck for orphaned images
-    QSet<std::string> orphanedImages;
+    activateMultiMatchConfig(PmMultiMatchConfig());
+}
+
+void PmCore::activateMultiMatchConfig(const PmMultiMatchConfig& mCfg)
+{
+    // edits of the outgoing config are moot
     {
         QMutexLocker locker(&m_matchConfigMutex);
-        orphanedImages
-            = m_matchPresets.orphanedImages(m_multiMatchConfig, newCfg);
+        m_pendingEdits.clear();
     }
+    m_editTimer->stop();
 
-    // reset no-match reaction
-    onNoMatchReactionChanged(PmReaction());
-
-    // notify other modules about changing size
-    emit sigMultiMatchConfigSizeChanged(0);
+    // the whole config is swapped in as one transaction
+    m_decisionEngine.clearLingers();
+    size_t newSz = mCfg.size();
+    QSet<std::string> orphanedImages;
+    {
+        QMutexLocker locker(&m_matchConfigMutex);
+        PmMultiMatchConfig oldCfg = m_multiMatchConfig;
+        m_multiMatchConfig = mCfg;
+        m_multiMatchHash = PmMultiMatchHash(mCfg);
+        m_imageStore.addRefs(mCfg);
+        m_imageStore.removeRefs(oldCfg);
+        orphanedImages = m_imageStore.orphanedImages(oldCfg);
+    }
+    compileMatchConfig();
+    {
+        QMutexLocker locker(&m_matchImagesMutex);
+        m_matchImages.assign(newSz, QImage());
+    }
 
-    // reconfigure the filter
+    // reconfigure the filter: one resize, one config publish
     auto fr = activeFilterRef();
     auto filterData = fr.filterData();
     if (filterData) {
-        pm_resize_match_entries(filterData, 0);
+        std::vector<pm_match_entry_config> filterCfgs;
+        filterCfgs.reserve(newSz);
+        for (const auto &cfg : mCfg) {
+            filterCfgs.push_back(cfg.filterCfg);
+        }
+        pm_set_match_entry_configs(filterData, newSz, filterCfgs.data());
     }
 
-    // finish updating state and notifying
-    {
-        QMutexLocker locker(&m_matchConfigMutex);
-        m_multiMatchConfig = PmMultiMatchConfig();
-        emit sigActivePresetDirtyChanged();
+    // notify other modules
+    emit sigMultiMatchConfigSizeChanged(newSz);
+    for (size_t i = 0; i < newSz; ++i) {
+        emit sigMatchConfigChanged(i, mCfg[i]);
     }
-    {
-        QMutexLocker locker(&m_matchImagesMutex);
-        m_matchImages.clear();
+    emit sigNoMatchReactionChanged(mCfg.noMatchReaction);
+    emit sigActivePresetDirtyChanged();
+
+    // load images; each file is decoded once, however many entries use it
+    if (m_runningEnabled) {
+        std::set<std::string> filenames;
+        for (const auto &cfg : mCfg) {
+            if (cfg.matchImgFilename.size())
+                filenames.insert(cfg.matchImgFilename);
+        }
+        for (auto it = m_imageLoads.begin(); it != m_imageLoads.end();) {
+            if (filenames.count(it.key())) {
+                ++it;
+            } else {
+                it->future.cancel();
+                it = m_imageLoads.erase(it);
+            }
+        }
+        for (const auto &filename : filenames) {
+            if (!m_imageLoads.contains(filename))
+                requestImage(filename);
+        }
     }
+
+    // force toggle scene items and filters to proper values
+    m_forceSceneItemRefresh = true;
     onMatchConfigSelect(0);
 
     // report orphaned images
@@ -1485,16 +2141,6 @@ void PmCore::resetMultiMatchConfig(const PmMultiMatchConfig *newCfg)
     }
 }
 
-void PmCore::activateMultiMatchConfig(const PmMultiMatchConfig& mCfg)
-{
-    resetMultiMatchConfig(&mCfg);
-    for (size_t i = 0; i < mCfg.size(); ++i) {
-        onMatchConfigInsert(i, mCfg[i]);
-    }
-    onNoMatchReactionChanged(mCfg.noMatchReaction);
-    onMatchConfigSelect(0);
-}
-
 void PmCore::activeFilterChanged()
 {
     if (!m_activeFilter.isValid()) {
@@ -1519,449 +2165,330 @@ void PmCore::onPeriodicUpdate()
 {
     m_periodicUpdateActive = true;
     if (m_availableTransitions.empty()) {
-        m_availableTransitions = getAvailableTransitions();
+        auto transitions = getAvailableTransitions();
+        if (transitions.size()) {
+            {
+                QMutexLocker locker(&m_scenesMutex);
+                m_availableTransitions = transitions;
+            }
+            // scene switching transitions are resolved when compiling
+            compileMatchConfig();
+        }
     }
     if (m_runningEnabled) {
-        scanScenes();
+        uint64_t timeNs = os_gettime_ns();
+        if (m_sceneGraphDirty.exchange(false)
+         || timeNs - m_lastSceneScanNs >= k_sceneCheckIntervalNs) {
+            m_lastSceneScanNs = timeNs;
+            scanScenes();
+        }
     } else if (m_availableTransitions.size()) {
         m_periodicUpdateTimer->stop();
     }
     m_periodicUpdateActive = false;
 }
 
-void PmCore::onFrameProcessed(PmMultiMatchResults newResults)
+void PmCore::onFrameProcessed()
 {
-    QTime currTime = QTime::currentTime();
-
-    // expired cooldown info disappers
-    QSet<size_t> expCooldowns = m_cooldownList.removeExpired(currTime);
-    for (size_t i : expCooldowns) {
-        emit sigCooldownActive(i, false);
-    }
+    // only the latest frame matters; skipped frames are counted by the ring
+    auto slot = m_resultsRing.takeLatest();
+    if (!slot)
+        return;
 
-    // expired lingers for scenes will disappear, allowing other scenes
-    QSet<size_t> expiredSceneLingers
-        = m_sceneLingerQueue.removeExpired(currTime);
+    m_nextResults = slot->results;
+    processResults(os_gettime_ns());
+}
 
-    // expired lingers
-    m_expiredLingers = m_lingerList.removeExpired(currTime);
-    for (size_t expIdx : m_expiredLingers) {
-        emit sigLingerActive(expIdx, false);
-        PmReaction expReaction = reaction(expIdx);
-        if (expReaction.cooldownMs > 0) {
-            QTime futureTime = currTime.addMSecs(int(expReaction.cooldownMs));
-            m_cooldownList.push_back(
-                {expIdx, currTime.addMSecs(int(expReaction.cooldownMs))});
-            emit sigCooldownActive(expIdx, true);
-        }
+void PmCore::onDeadlineReached()
+{
+    // deadline may have been cleared, or moved by a newer frame
+    uint64_t timeNs = os_gettime_ns();
+    uint64_t deadline = m_decisionEngine.nextDeadline();
+    if (deadline == UINT64_MAX)
+        return;
+    if (deadline > timeNs) {
+        scheduleDeadline(timeNs);
+        return;
     }
 
-    // scene reaction index gets determined to select/maintain just one target scene
-    size_t sceneReactionIdx = (size_t)-1;
-    if (m_sceneLingerQueue.size()) {
-        sceneReactionIdx = m_sceneLingerQueue.top().matchIndex;
+    // re-evaluate the latest results at the deadline
+    {
+        QMutexLocker resLocker(&m_resultsMutex);
+        m_nextResults = m_results;
     }
+    processResults(timeNs);
+}
 
-    bool anythingWasMatched = false;
-    bool anythingIsMatched = false;
-    
-    for (size_t matchIndex = 0; matchIndex < m_results.size(); matchIndex++) {
-        if (m_results[matchIndex].isMatched) {
-            anythingWasMatched = true;
-            break;
-        }
+void PmCore::scheduleDeadline(uint64_t timeNs)
+{
+    uint64_t deadline = m_decisionEngine.nextDeadline();
+    if (deadline == UINT64_MAX) {
+        m_deadlineTimer->stop();
+        return;
     }
 
-    for (size_t matchIndex = 0; matchIndex < newResults.size(); matchIndex++) {
-        // assign match state
-        auto &newResult = newResults[matchIndex];
-        auto cfg = matchConfig(matchIndex);
-        newResult.percentageMatched
-            = float(newResult.numMatched) / float(newResult.numCompared) * 100.f;
-        newResult.isMatched
-            = newResult.percentageMatched >= cfg.totalMatchThresh;
-        if (cfg.invertResult)
-            newResult.isMatched = !newResult.isMatched;
-
-        // notify other modules of the result and match state
-        emit sigNewMatchResults(matchIndex, newResults[matchIndex]);
-
-        const PmReaction &reaction = cfg.reaction;
-
-        if (!m_switchingEnabled || !cfg.filterCfg.is_enabled
-         || !reaction.isSet()) {
-            // no reaction necessary
-            continue;
-        }
-
-        bool isMatched = newResult.isMatched;
-        bool wasMatched = matchResults(matchIndex).isMatched;
-
-        if (!wasMatched && isMatched
-         && m_cooldownList.contains(matchIndex)) {
-            // prevent "switching on" after a cooldown
-            newResult.isMatched = false;
-            isMatched = false;
-        } else if (!isMatched && m_expiredLingers.contains(matchIndex)) {
-            // emulate matched -> unmatched when a linger expires
-            wasMatched = true;
-        }
-
-        // has anything at all matched?
-        anythingIsMatched |= isMatched;
+    // round up, so the timer doesn't fire before the deadline
+    uint64_t waitNs = deadline > timeNs ? deadline - timeNs : 0;
+    int waitMs = int(std::min<uint64_t>(
+        (waitNs + 999999) / 1000000, uint64_t(INT_MAX)));
+    m_deadlineTimer->start(waitMs);
+}
 
-        // "match changed" will trigger match/unmatch reactions
-        bool matchChanged = (isMatched != wasMatched);
+void PmCore::processResults(uint64_t timeNs)
+{
+    // decisions are made on a compiled snapshot of the configuration,
+    // without locking, then carried out in order
+    PmCompiledConfigPtr ccPtr = std::atomic_load(&m_compiledConfig);
+    const PmCompiledConfig &cc = *ccPtr;
+    PmMultiMatchResults &newResults = m_nextResults;
 
-        if (matchChanged) {
-            // trigger match/unmatch reactions (or activate lingers)
-            execReaction(
-                matchIndex, currTime, reaction, isMatched, sceneReactionIdx);
-        }
+    m_decisionEngine.process(
+        cc, newResults, timeNs, m_switchingEnabled, m_decisions);
+    scheduleDeadline(timeNs);
 
-        if ((sceneReactionIdx == (size_t)-1 || matchIndex < sceneReactionIdx)
-            && reaction.hasSceneAction()
-            && !m_cooldownList.contains(matchIndex)) {
-            // possible scene actions are always evaluated until target scene is found
-            bool isOn = isMatched || m_lingerList.contains(matchIndex);
-            execSceneAction(matchIndex, reaction, isOn, sceneReactionIdx);
-        }
+    // notify other modules of the results and match states
+    for (size_t i = 0; i < newResults.size(); ++i) {
+        emit sigNewMatchResults(i, newResults[i]);
     }
 
-    if (m_switchingEnabled) {
-        bool everythingSwitched = (anythingWasMatched != anythingIsMatched);
-        const PmReaction &nmr = m_multiMatchConfig.noMatchReaction;
-
-        if (everythingSwitched) {
-            // independent anything/nothing match actions
-            execIndependentActions("global", nmr, anythingIsMatched);
-        }
-
-        // finalize target scene evaluation and activation
-        std::string targetSceneName, targetTransition;
-        if (sceneReactionIdx != (size_t)-1) {
-            const PmReaction &reaction
-                = m_multiMatchConfig[sceneReactionIdx].reaction;
-            if (m_lingerList.contains(sceneReactionIdx)
-             || newResults[sceneReactionIdx].isMatched) {
-                // match scene reaction entry
-                reaction.getMatchScene(targetSceneName, targetTransition);
-            } else {
-                reaction.getUnmatchScene(targetSceneName, targetTransition);
-            }
-        } else {
-            if (anythingIsMatched) {
-                nmr.getMatchScene(targetSceneName, targetTransition);
+    PmToggleBatch toggles;
+    const PmSceneTarget *sceneTarget = nullptr;
+    for (const PmDecision &decision : m_decisions) {
+        switch (decision.type) {
+        case PmDecisionType::LingerActive:
+            emit sigLingerActive(decision.matchIdx, decision.on);
+            break;
+        case PmDecisionType::CooldownActive:
+            emit sigCooldownActive(decision.matchIdx, decision.on);
+            break;
+        case PmDecisionType::RunActions:
+            if (decision.matchIdx == PmDecision::k_global) {
+                execIndependentActions("global", decision.on
+                    ? cc.globalMatchPlan : cc.globalUnmatchPlan, toggles);
             } else {
-                nmr.getUnmatchScene(targetSceneName, targetTransition);
+                size_t i = decision.matchIdx;
+                execIndependentActions(cc.labels[i],
+                    decision.on ? cc.matchPlans[i] : cc.unmatchPlans[i],
+                    toggles);
             }
-
+            break;
+        case PmDecisionType::SwitchScene:
+            sceneTarget = decision.sceneTarget;
+            break;
         }
-        switchScene(targetSceneName, targetTransition);
     }
 
-    // store new results
+    // all toggles of the pass show up in the same frame, and before a scene
+    // switch of the same pass; both run on the same serialized target
+    if (!toggles.empty()) {
+        m_actionExecutor.submit("toggles",
+            [toggles = std::move(toggles)]() { toggles.apply(); });
+    }
+    if (sceneTarget)
+        switchScene(*sceneTarget);
+
+    // store new results; the previous vector is kept to be reused
     {
         QMutexLocker resLocker(&m_resultsMutex);
-        m_results = newResults;
+        m_results.swap(newResults);
     }
 
     // cleanup temp state variables 
     if (m_forceSceneItemRefresh)
         m_forceSceneItemRefresh = false;
-    m_expiredLingers.clear();
-}
-
-void PmCore::execReaction(
-    size_t matchIdx, const QTime &time,
-    const PmReaction &reaction, bool switchedOn, size_t &sceneReactionIdx)
-{
-    bool actionsTaken = false;
-    bool lingerActivated = false;
-
-    if (switchedOn) {
-        // undo any linger status for anything switched on
-        m_sceneLingerQueue.removeByMatchIndex(matchIdx);
-        if (m_lingerList.removeByMatchIndex(matchIdx)) {
-            emit sigLingerActive(matchIdx, false);
-        }
-    }
-
-    if (!switchedOn && reaction.lingerMs > 0
-     && !m_expiredLingers.contains(matchIdx)) {
-        // activate linger
-        lingerActivated = true;
-        QTime futureTime = time.addMSecs(int(reaction.lingerMs));
-        m_lingerList.push_back({matchIdx, futureTime});
-        if (reaction.hasMatchAction(PmActionType::Scene))
-            m_sceneLingerQueue.push({matchIdx, futureTime});
-        emit sigLingerActive(matchIdx, true);
-    }
-
-    if (!lingerActivated) {
-        // activate independent match/unmatch actions
-        if (execIndependentActions(
-                matchConfigLabel(matchIdx), reaction, switchedOn)) {
-            actionsTaken = true;
-        }
-        // process scene match/unmatch actions
-        if (execSceneAction(matchIdx, reaction, switchedOn, sceneReactionIdx)) {
-            actionsTaken = true;
-        }
-        // activate cooldown
-        if (actionsTaken && !switchedOn && reaction.cooldownMs > 0) {
-            m_cooldownList.push_back(
-                {matchIdx, time.addMSecs(int(reaction.cooldownMs))});
-            emit sigCooldownActive(matchIdx, true);
-        }
-    }
 }
 
-bool PmCore::execSceneAction(
-    size_t matchIdx, const PmReaction &reaction,
-    bool switchedOn, size_t &sceneReactionIdx)
+void PmCore::updateCurrentScene()
 {
-    // higher priority scene is active ? => don't switch
-    if (sceneReactionIdx != (size_t)-1 && matchIdx > sceneReactionIdx)
-        return false;
-
-    std::string targetSceneName;
-    std::string targetTransition;
-
-    // get switch info
-    if (switchedOn) {
-        reaction.getMatchScene(targetSceneName, targetTransition);
-    } else {
-        reaction.getUnmatchScene(targetSceneName, targetTransition);
-    }
-
-    // nothing to switch to?
-    if (targetSceneName.empty())
-        return false;
-
-    // check that scene exists
-    QMutexLocker locker(&m_scenesMutex);
-    auto find = m_scenes.find(targetSceneName);
-    if (find == m_scenes.end()) {
-        return false;
+    obs_source_t *currSceneSrc = obs_frontend_get_current_scene();
+    obs_weak_source_t *currSceneWs = obs_source_get_weak_source(currSceneSrc);
+    {
+        QMutexLocker locker(&m_currentSceneMutex);
+        m_currentScene = currSceneWs;
     }
-
-    sceneReactionIdx = matchIdx;
-    return true;
+    obs_weak_source_release(currSceneWs);
+    obs_source_release(currSceneSrc);
 }
 
-void PmCore::switchScene(
-    const std::string &targetSceneName, const std::string &targetTransition)
+void PmCore::switchScene(const PmSceneTarget &target)
 {
-    if (targetSceneName.empty())
+    if (!target.sceneWs)
         return;
 
-    obs_source_t *currSceneSrc = obs_frontend_get_current_scene();
-    obs_source_t *targetSceneSrc = nullptr;
-
-    // find reference to the target scene
+    // current scene is tracked through frontend events; a switch that was
+    // just requested counts as done, so it isn't repeated every frame
     {
-        QMutexLocker locker(&m_scenesMutex);
-        auto find = m_scenes.find(targetSceneName);
-        if (find != m_scenes.end()) {
-            OBSWeakSource sceneWs = find->wsrc;
-            targetSceneSrc = obs_weak_source_get_source(sceneWs);
-        }
+        QMutexLocker locker(&m_currentSceneMutex);
+        if (m_currentScene == target.sceneWs)
+            return;
+        m_currentScene = target.sceneWs;
     }
 
-    // do the switch when necessary
+    // the switch is queued behind toggles that were submitted before it
+    OBSWeakSource sceneWs = target.sceneWs;
+    OBSWeakSource transitionWs = target.transitionWs;
+    m_actionExecutor.submit("toggles", [sceneWs, transitionWs]() {
+        obs_source_t *targetSceneSrc = obs_weak_source_get_source(sceneWs);
+        if (!targetSceneSrc)
+            return;
 
-    // scene activation was copied (and slightly simplified) from Advanced Scene Switcher:
-    // https://github.com/WarmUpTill/SceneSwitcher/blob/05540b61a118f2190bb3fae574c48aea1b436ac7/src/advanced-scene-switcher.cpp#L1066
+        // scene activation was copied (and slightly simplified) from Advanced Scene Switcher:
+        // https://github.com/WarmUpTill/SceneSwitcher/blob/05540b61a118f2190bb3fae574c48aea1b436ac7/src/advanced-scene-switcher.cpp#L1066
 
-    if (targetSceneSrc) {
-        if (targetSceneSrc != currSceneSrc) {
-            obs_source_t* transitionSrc = nullptr;
-            if (!targetTransition.empty()) {
-                auto find = m_availableTransitions.find(targetTransition);
-                if (find != m_availableTransitions.end()) {
-                    auto weakTransSrc = *find;
-                    transitionSrc = obs_weak_source_get_source(weakTransSrc);
-                }
-            }
-
-            obs_source_t *currTransition = nullptr;
-            if (transitionSrc) {
-                currTransition = obs_frontend_get_current_transition();
-                obs_frontend_set_current_transition(transitionSrc);
-                obs_source_release(transitionSrc);
-            }
-            obs_frontend_set_current_scene(targetSceneSrc);
-            if (transitionSrc) {
-                obs_source_release(currTransition);
-            }
+        obs_source_t *transitionSrc = transitionWs
+            ? obs_weak_source_get_source(transitionWs) : nullptr;
+        obs_source_t *currTransition = nullptr;
+        if (transitionSrc) {
+            currTransition = obs_frontend_get_current_transition();
+            obs_frontend_set_current_transition(transitionSrc);
+            obs_source_release(transitionSrc);
+        }
+        obs_frontend_set_current_scene(targetSceneSrc);
+        if (transitionSrc) {
+            obs_source_release(currTransition);
         }
         obs_source_release(targetSceneSrc);
-    }
-
-    if (currSceneSrc)
-        obs_source_release(currSceneSrc);
+    });
 }
 
-bool PmCore::execIndependentActions(const std::string &cfgName,
-    const PmReaction &reaction, bool switchedOn)
+void PmCore::compileMatchConfig()
 {
-    bool actionsTaken = false;
-    const auto &actions
-        = switchedOn ? reaction.matchActions : reaction.unmatchActions;
-    for (const auto &action : actions) {
-        if (!action.isSet()) continue;
-        actionsTaken = true;
+    // scenes lock is taken first, same as scanScenes() does
+    PmCompiledConfigPtr cc;
+    {
+        QMutexLocker scenesLocker(&m_scenesMutex);
+        QMutexLocker cfgLocker(&m_matchConfigMutex);
+        PmSceneGraph graph;
+        graph.scenes = m_scenes;
+        graph.sceneItems = m_sceneItems;
+        graph.filters = m_filters;
+        graph.audioSources = m_audioSources;
+        graph.transitions = m_availableTransitions;
+        cc = std::make_shared<const PmCompiledConfig>(
+            m_multiMatchConfig, graph);
+    }
+    std::atomic_store(&m_compiledConfig, cc);
+}
 
-        if (action.actionType == PmActionType::SceneItem) {
-            obs_sceneitem_t *sceneItem = nullptr;
-            {
-                QMutexLocker locker(&m_scenesMutex);
-                auto find = m_sceneItems.find(
-                    action.targetElement);
-                if (find != m_sceneItems.end()) {
-                    OBSSceneItem sceneItemSi = find->si;
-                    sceneItem = sceneItemSi;
-                }
-            }
-            if (sceneItem) {
-                bool isVisible = obs_sceneitem_visible(sceneItem);
-                if (action.actionCode == (size_t)PmToggleCode::On
-                 && !isVisible) {
-                    obs_sceneitem_set_visible(sceneItem, true);
-                } else if (action.actionCode == (size_t)PmToggleCode::Off
-                        && isVisible) {
-                    obs_sceneitem_set_visible(sceneItem, false);
-                }
-            }
-        } else if (action.actionType == PmActionType::Filter) {
-            obs_source_t *filterSrc = nullptr;
-            {
-                QMutexLocker locker(&m_scenesMutex);
-                auto find =
-                    m_filters.find(action.targetElement);
-                if (find != m_filters.end()) {
-                    OBSWeakSource filterWs = find->wsrc;
-                    filterSrc = obs_weak_source_get_source(
-                        filterWs);
-                }
-            }
-            if (filterSrc) {
-                bool isEnabled = obs_source_enabled(filterSrc);
-                if (action.actionCode == (size_t)PmToggleCode::On
-                 && !isEnabled) {
-                    obs_source_set_enabled(filterSrc, true);
-                } else if (action.actionCode == (size_t)PmToggleCode::Off
-                        && isEnabled) {
-                    obs_source_set_enabled(filterSrc, false);
-                }
-                obs_source_release(filterSrc);
-            }
-        } else if (action.actionType == PmActionType::ToggleMute) {
-            obs_source_t *audioSrc = nullptr;
-            {
-                QMutexLocker locker(&m_scenesMutex);
-                auto find = m_audioSources.find(action.targetElement);
-                if (find != m_audioSources.end()) {
-                    OBSWeakSource audioWs = find->wsrc;
-                    audioSrc = obs_weak_source_get_source(audioWs);
-                }
-            }
-            if (audioSrc) {
-                bool isOn = !obs_source_muted(audioSrc);
-                if (action.actionCode == (size_t)PmToggleCode::On
-                 && !isOn) {
-                    obs_source_set_muted(audioSrc, false);
-                } else if (action.actionCode == (size_t)PmToggleCode::Off
-                        && isOn) {
-                    obs_source_set_muted(audioSrc, true);
-                }
-                obs_source_release(audioSrc);
-            }
+bool PmCore::execIndependentActions(const std::string &cfgName,
+    const PmActionPlan &plan, PmToggleBatch &toggles)
+{
+    // targets were resolved when the configuration was compiled; actions
+    // run on the executor, serialized per target, except for file lines
+    for (const PmActionStep &step : plan) {
+        const PmAction &action = *step.action;
+        size_t actionCode = action.actionCode;
+
+        if (action.actionType == PmActionType::SceneItem
+         || action.actionType == PmActionType::Filter
+         || action.actionType == PmActionType::ToggleMute) {
+            // toggles are applied together, after the decision pass
+            toggles.add(step);
         } else if (action.actionType == PmActionType::Hotkey) {
-            obs_hotkey_inject_event(action.keyCombo, false);
-            obs_hotkey_inject_event(action.keyCombo, true);
-            obs_hotkey_inject_event(action.keyCombo, false);
+            obs_key_combination_t keyCombo = action.keyCombo;
+            m_actionExecutor.submit("hotkey", [keyCombo]() {
+                obs_hotkey_inject_event(keyCombo, false);
+                obs_hotkey_inject_event(keyCombo, true);
+                obs_hotkey_inject_event(keyCombo, false);
+            });
         } else if (action.actionType == PmActionType::FrontEndAction) {
-            switch ((PmFrontEndAction)action.actionCode) {
-            case PmFrontEndAction::StreamingStart:
-                obs_frontend_streaming_start(); break;
-            case PmFrontEndAction::StreamingStop:
-                obs_frontend_streaming_stop(); break;
-            case PmFrontEndAction::RecordingStart:
-                obs_frontend_recording_start(); break;
-            case PmFrontEndAction::RecordingStop:
-                obs_frontend_recording_stop(); break;
-            case PmFrontEndAction::RecordingPause:
-                obs_frontend_recording_pause(true); break;
-            case PmFrontEndAction::RecordingUnpause:
-                obs_frontend_recording_pause(false); break;
-            case PmFrontEndAction::ReplayBufferStart:
-                obs_frontend_replay_buffer_start(); break;
-            case PmFrontEndAction::ReplayBufferSave:
-                obs_frontend_replay_buffer_save(); break;
-            case PmFrontEndAction::ReplayBufferStop:
-                obs_frontend_replay_buffer_stop(); break;
-            case PmFrontEndAction::TakeScreenshot:
-                obs_frontend_take_screenshot(); break;
-            case PmFrontEndAction::StartVirtualCam:
-                obs_frontend_start_virtualcam(); break;
-            case PmFrontEndAction::StopVirtualCam:
-                obs_frontend_stop_virtualcam(); break;
-            case PmFrontEndAction::ResetVideo:
-                obs_frontend_reset_video();
-            }
+            m_actionExecutor.submit("frontend", [actionCode]() {
+                switch ((PmFrontEndAction)actionCode) {
+                case PmFrontEndAction::StreamingStart:
+                    obs_frontend_streaming_start(); break;
+                case PmFrontEndAction::StreamingStop:
+                    obs_frontend_streaming_stop(); break;
+                case PmFrontEndAction::RecordingStart:
+                    obs_frontend_recording_start(); break;
+                case PmFrontEndAction::RecordingStop:
+                    obs_frontend_recording_stop(); break;
+                case PmFrontEndAction::RecordingPause:
+                    obs_frontend_recording_pause(true); break;
+                case PmFrontEndAction::RecordingUnpause:
+                    obs_frontend_recording_pause(false); break;
+                case PmFrontEndAction::ReplayBufferStart:
+                    obs_frontend_replay_buffer_start(); break;
+                case PmFrontEndAction::ReplayBufferSave:
+                    obs_frontend_replay_buffer_save(); break;
+                case PmFrontEndAction::ReplayBufferStop:
+                    obs_frontend_replay_buffer_stop(); break;
+                case PmFrontEndAction::TakeScreenshot:
+                    obs_frontend_take_screenshot(); break;
+                case PmFrontEndAction::StartVirtualCam:
+                    obs_frontend_start_virtualcam(); break;
+                case PmFrontEndAction::StopVirtualCam:
+                    obs_frontend_stop_virtualcam(); break;
+                case PmFrontEndAction::ResetVideo:
+                    obs_frontend_reset_video();
+                }
+            });
         } else if (action.actionType == PmActionType::File) {
-            PmFileActionType fileAction = (PmFileActionType)action.actionCode;
+            PmFileActionType fileAction = (PmFileActionType)actionCode;
+            if (fileAction != PmFileActionType::WriteAppend
+             && fileAction != PmFileActionType::WriteTruncate) {
+                continue;
+            }
+
+            // text is formatted at trigger time, not when it's written
             QDateTime now = QDateTime::currentDateTime();
             std::string filename = action.formattedFileString(
                 action.targetElement, cfgName, now);
-
-            if (fileAction == PmFileActionType::WriteAppend
-             || fileAction == PmFileActionType::WriteTruncate) {
-                //QFileInfo fileInfo(action.targetElement.data());
-                QFile file(filename.data());
-                QIODevice::OpenMode flags = QIODevice::WriteOnly;
-                if (fileAction == PmFileActionType::WriteAppend) {
-                    flags |= QIODevice::Append;
-                } else if (fileAction == PmFileActionType::WriteTruncate) {
-                    flags |= QIODevice::Truncate;
-                }
-                file.open(flags);
-                if (!file.isOpen()) {
-                    blog(LOG_ERROR, "Error opening %s: %s",
-                         filename.data(), file.errorString().toUtf8().data());
-                    continue;
-                }
-                std::string entry = action.formattedFileString(
-                    action.targetDetails, cfgName, now);
-                QTextStream stream(&file);
-                stream << entry.data() << "\r\n";
-                file.close();
-            }
+            std::string entry = action.formattedFileString(
+                action.targetDetails, cfgName, now);
+            entry += "\r\n";
+
+            // the writer thread keeps files open and batches lines
+            m_fileWriter.write(filename,
+                fileAction == PmFileActionType::WriteTruncate,
+                std::move(entry));
         }
     }
-    return actionsTaken;
+    return plan.size() > 0;
+}
+
+static void release_match_image(void *opaque)
+{
+    delete static_cast<QImage*>(opaque);
 }
 
 void PmCore::supplyImageToFilter(
     struct pm_filter_data* data, size_t matchIdx, const QImage &image)
 {
     if (data) {
-        pthread_mutex_lock(&data->mutex);
-        auto entryData = data->match_entries + matchIdx;
+        // borders that would never be compared are cropped away, so that
+        // the filter samples fewer pixels; the original is kept for the UI
+        QRect region;
+        if (!image.isNull()) {
+            auto filterCfg = matchConfig(matchIdx).filterCfg;
+            if (filterCfg.mask_alpha)
+                region = m_imageStore.alphaRegionOf(image);
+            if (region.isNull())
+                region = activeImageRegion(image, filterCfg);
+        }
 
-        size_t sz = (size_t)(image.bytesPerLine()) * (size_t)(image.height());
-        if (sz) {
-            entryData->match_img_data = bmalloc(sz);
-            memcpy(entryData->match_img_data, image.bits(), sz);
+        // filter shares textures between entries with identical pixels
+        QImage cropped;
+        uint64_t hash = 0;
+        if (region == image.rect()) {
+            cropped = image;
+            hash = m_imageStore.hashOf(image);
+            if (!hash)
+                hash = PmImageStore::contentHash(image);
         } else {
-            entryData->match_img_data = nullptr;
+            cropped = image.copy(region);
+            hash = PmImageStore::contentHash(cropped);
         }
 
-        entryData->match_img_width = uint32_t(image.width());
-        entryData->match_img_height = uint32_t(image.height());
-        pthread_mutex_unlock(&data->mutex);
+        // the filter borrows the pixels until its upload is done; the
+        // lent reference keeps them alive without copying
+        size_t sz = (size_t)(cropped.bytesPerLine())
+                  * (size_t)(cropped.height());
+        QImage *lent = sz ? new QImage(cropped) : nullptr;
+        pm_supply_match_image(data, matchIdx, hash,
+            uint32_t(cropped.width()), uint32_t(cropped.height()),
+            region.left(), region.top(),
+            lent ? lent->constBits() : nullptr, sz,
+            lent ? release_match_image : nullptr, lent);
     }
 }
 
@@ -1973,33 +2500,40 @@ void PmCore::pmSave(obs_data_t *saveData)
     {
         obs_data_set_bool(saveObj, "running_enabled", m_runningEnabled);
         obs_data_set_bool(saveObj, "switching_enabled", m_switchingEnabled);
+        obs_data_set_int(saveObj, "action_concurrency",
+                         m_actionExecutor.maxConcurrency());
     }
 
     // match configuration and presets
     {
         QMutexLocker locker(&m_matchConfigMutex);
 
-        // match presets
+        // match presets; only those changed since the last save are
+        // serialized again, the rest reuse their saved objects
+        for (auto it = m_matchPresets.begin(); it != m_matchPresets.end();
+             ++it) {
+            if (!m_savedPresets.contains(it.key())) {
+                obs_data_t *matchPresetObj = it->save(it.key());
+                m_savedPresets.insert(it.key(), OBSData(matchPresetObj));
+                obs_data_release(matchPresetObj);
+            }
+        }
         obs_data_array_t *matchPresetArray = obs_data_array_create();
-        for (const auto &name: m_matchPresets.keys()) {
-            PmMultiMatchConfig presetCfg = m_matchPresets[name];
-            obs_data_t *matchPresetObj = presetCfg.save(name);
+        for (const auto &matchPresetObj : m_savedPresets) {
             obs_data_array_push_back(matchPresetArray, matchPresetObj);
-            obs_data_release(matchPresetObj);
         }
         obs_data_set_array(saveObj, "match_presets", matchPresetArray);
         obs_data_array_release(matchPresetArray);
 
         // active match config/preset
-        obs_data_t *activeCfgObj;
-        if (m_activeMatchPreset.empty()) {
-            activeCfgObj = m_multiMatchConfig.save("");
+        auto findSaved = m_savedPresets.find(m_activeMatchPreset);
+        if (findSaved != m_savedPresets.end()) {
+            obs_data_set_obj(saveObj, "match_config", *findSaved);
         } else {
-            PmMultiMatchConfig presetCfg = m_matchPresets[m_activeMatchPreset];
-            activeCfgObj = presetCfg.save(m_activeMatchPreset);
+            obs_data_t *activeCfgObj = multiMatchConfig().save("");
+            obs_data_set_obj(saveObj, "match_config", activeCfgObj);
+            obs_data_release(activeCfgObj);
         }
-        obs_data_set_obj(saveObj, "match_config", activeCfgObj);
-        obs_data_release(activeCfgObj);
     }
 
     // preview config
@@ -2017,6 +2551,14 @@ void PmCore::pmSave(obs_data_t *saveData)
 
 void PmCore::pmLoad(obs_data_t *data)
 {
+    // frontend calls this on the UI thread; loading activates a config,
+    // which touches image loads and timers that belong to the core thread
+    if (thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this, data]() { pmLoad(data); },
+                                  Qt::BlockingQueuedConnection);
+        return;
+    }
+
     obs_data_t *loadObj = obs_data_get_obj(data, "pixel-match-switcher");
 
     m_selectedMatchIndex = 0;
@@ -2028,22 +2570,55 @@ void PmCore::pmLoad(obs_data_t *data)
 
         obs_data_set_default_bool(loadObj, "switching_enabled", true);
         m_switchingEnabled = obs_data_get_bool(loadObj, "switching_enabled");
+
+        obs_data_set_default_int(loadObj, "action_concurrency",
+                                 PmActionExecutor::k_defaultConcurrency);
+        m_actionExecutor.setMaxConcurrency(
+            int(obs_data_get_int(loadObj, "action_concurrency")));
     }
 
     // match configuration and presets
     {
         // match presets
-        m_matchPresets.clear();
         obs_data_array_t *matchPresetArray
             = obs_data_get_array(loadObj, "match_presets");
-        size_t count = obs_data_array_count(matchPresetArray);
-        for (size_t i = 0; i < count; ++i) {
-            obs_data_t *matchPresetObj
-                = obs_data_array_item(matchPresetArray, i);
-            std::string presetName
-                = obs_data_get_string(matchPresetObj, "name");
-            m_matchPresets[presetName] = PmMultiMatchConfig(matchPresetObj);
-            obs_data_release(matchPresetObj);
+        {
+            QMutexLocker locker(&m_matchConfigMutex);
+            for (const auto &presetCfg : m_matchPresets) {
+                m_imageStore.removeRefs(presetCfg);
+            }
+            for (auto it = m_savedPresets.begin(); it != m_savedPresets.end();
+                 ++it) {
+                if (m_matchPresets.contains(it.key()))
+                    continue;
+                forEachPresetImage(*it, [this](const char *filename) {
+                    m_imageStore.removeRef(filename);
+                });
+            }
+            m_matchPresets.clear();
+            m_savedPresets.clear();
+            m_presetHashes.clear();
+
+            // presets are parsed when selected, exported or compared
+            size_t count = obs_data_array_count(matchPresetArray);
+            for (size_t i = 0; i < count; ++i) {
+                obs_data_t *matchPresetObj
+                    = obs_data_array_item(matchPresetArray, i);
+                std::string presetName
+                    = obs_data_get_string(matchPresetObj, "name");
+                auto find = m_savedPresets.find(presetName);
+                if (find != m_savedPresets.end()) {
+                    forEachPresetImage(*find, [this](const char *filename) {
+                        m_imageStore.removeRef(filename);
+                    });
+                }
+                forEachPresetImage(matchPresetObj,
+                    [this](const char *filename) {
+                        m_imageStore.addRef(filename);
+                    });
+                m_savedPresets[presetName] = OBSData(matchPresetObj);
+                obs_data_release(matchPresetObj);
+            }
         }
         obs_data_array_release(matchPresetArray);
 
@@ -6,15 +6,24 @@
 #include <QPointer>
 #include <QImage>
 
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <QSet>
 
 #include <obs.hpp>
+#include <obs-frontend-api.h>
 
 #include "pm-filter-ref.hpp"
 #include "pm-structs.hpp"
-#include "pm-linger-queue.hpp"
+#include "pm-results-ring.hpp"
+#include "pm-compiled-config.hpp"
+#include "pm-decision-engine.hpp"
+#include "pm-action-executor.hpp"
+#include "pm-file-writer.hpp"
+#include "pm-image-io.hpp"
+#include "pm-image-store.hpp"
 #include "pm-dialog.hpp"
 #include "pm-module.h"
 #include "pm-filter.h"
@@ -23,6 +32,8 @@ struct obs_scene_item;
 struct obs_scene;
 struct pm_filter_data;
 class PmDialog;
+class PmPresetPack;
+struct PmToggleBatch;
 
 // plugin's C functions
 extern "C" void init_pixel_match_switcher(void);
@@ -30,6 +41,7 @@ extern "C" void free_pixel_match_switcher(void);
 
 // event handlers for OBS and filter events
 void pm_save_load_callback(obs_data_t *save_data, bool saving, void *corePtr);
+void pm_frontend_event_callback(enum obs_frontend_event event, void *corePtr);
 void on_frame_processed(struct pm_filter_data *filterData);
 void on_match_image_captured(struct pm_filter_data *filterData);
 
@@ -48,6 +60,8 @@ class PmCore : public QObject
     friend void on_match_image_captured(pm_filter_data *filterData);
     friend void pm_save_load_callback(
         obs_data_t *save_data, bool saving, void *corePtr);
+    friend void pm_frontend_event_callback(
+        enum obs_frontend_event event, void *corePtr);
 
 public:
     PmCore();
@@ -60,6 +74,7 @@ public:
     bool matchPresetExists(const std::string &name) const;
     PmMultiMatchConfig matchPresetByName(const std::string &name) const;
     size_t matchPresetSize(const std::string& name) const;
+    size_t matchPresetHash(const std::string &name) const;
     QList<std::string> matchPresetNames() const;
     bool matchConfigDirty() const;
 
@@ -87,6 +102,12 @@ public:
 
     PmMultiMatchResults multiMatchResults() const;
     PmMatchResults matchResults(size_t matchIdx) const;
+    uint64_t framesProduced() const { return m_resultsRing.numProduced(); }
+    uint64_t framesDropped() const { return m_resultsRing.numDropped(); }
+    uint64_t framesStale() const { return m_resultsRing.numStale(); }
+    const PmActionExecutor &actionExecutor() const
+        { return m_actionExecutor; }
+    PmImageIo &imageIo() { return m_imageIo; }
     PmSourceHash scenes() const;
     QList<std::string> sceneNames() const;
     QList<std::string> sceneItemNames(const std::string &sceneName) const;
@@ -107,11 +128,9 @@ public:
 
 signals:
     void sigActiveFilterChanged(PmFilterRef newAf);
-    void sigScenesChanged(
-        QList<std::string> scenes, QList<std::string> sceneItems);
-    void sigAudioSourcesChanged(QList<std::string> audioSources);
+    void sigSceneGraphChanged(PmSceneGraphDelta delta);
 
-    void sigFrameProcessed(PmMultiMatchResults);
+    void sigFrameProcessed();
     void sigNewMatchResults(size_t matchIndex, PmMatchResults results);
     void sigShowException(std::string caption, std::string descr);
 
@@ -151,11 +170,13 @@ public slots:
         std::string filename, QList<std::string> selectedPresets);
     void onMatchPresetsImport(std::string filename);
     void onMatchPresetsAppend(PmMatchPresets presets);
+    void onMatchPresetsImportFinished();
 
     void onMultiMatchConfigReset();
     void onNoMatchReactionChanged(PmReaction noMatchReaction);
 
     void onMatchConfigChanged(size_t matchIndex, PmMatchConfig cfg);
+    void onMatchConfigEdited(size_t matchIndex, PmMatchConfig cfg);
     void onMatchConfigInsert(size_t matchIndex, PmMatchConfig cfg);
     void onMatchConfigRemove(size_t matchIndex);
     void onMatchConfigMoveUp(size_t matchIndex);
@@ -172,11 +193,23 @@ public slots:
 
 protected slots:
     void onPeriodicUpdate();
-    void onFrameProcessed(PmMultiMatchResults);
+    void onFrameProcessed();
+    void onDeadlineReached();
+    void flushMatchConfigEdits();
 
 protected:
     static QHash<std::string, OBSWeakSource> getAvailableTransitions();
 
+    static const uint64_t k_sceneCheckIntervalNs = 5000000000ULL;
+    static const int k_editCoalesceMs = 50;
+    static void onSceneGraphSignal(void *data, calldata_t *cd);
+    void renameReactionElements(const PmRenameMap &sceneRenames,
+        const PmRenameMap &siRenames, const PmRenameMap &fiRenames,
+        const PmRenameMap &audioRenames);
+    static void onSourceCreated(void *data, calldata_t *cd);
+    static void connectSourceSignals(obs_source_t *source, PmCore *core);
+    static void disconnectSourceSignals(obs_source_t *source, PmCore *core);
+
     void activate();
     void deactivate();
 
@@ -185,21 +218,32 @@ protected:
     void activateMatchConfig(size_t matchIndex, const PmMatchConfig& cfg,
         QSet<std::string>* orphanedImages = nullptr);
     void loadImage(size_t matchIndex);
-    void resetMultiMatchConfig(const PmMultiMatchConfig *newCfg = nullptr);
+    void requestImage(const std::string &filename);
+    void cancelImageLoads();
+    void onImageDecoded(
+        size_t matchIdx, const std::string &filename, const QImage &img);
+    void swapMatchConfigs(size_t idxA, size_t idxB);
+    void announceMatchImage(size_t matchIdx);
+    void resetMultiMatchConfig();
     void activateMultiMatchConfig(const PmMultiMatchConfig& mCfg);
     void activeFilterChanged();
 
+    const PmMultiMatchConfig *findMatchPreset(const std::string &name) const;
+    void materializeMatchPresets(const QList<std::string> &names) const;
+    void storeMatchPreset(
+        const std::string &name, const PmMultiMatchConfig &mcfg);
+    void extractPackImages(const PmMultiMatchConfig &mcfg);
+
     void supplyImageToFilter(
         struct pm_filter_data *data, size_t matchIdx, const QImage &image);
 
-    void execReaction(size_t matchIdx, const QTime &time,
-        const PmReaction &reaction, bool switchedOn, size_t &sceneReactionIdx);
+    void compileMatchConfig();
+    void processResults(uint64_t timeNs);
+    void scheduleDeadline(uint64_t timeNs);
     bool execIndependentActions(const std::string &cfgName,
-        const PmReaction &reaction, bool switchedOn);
-    bool execSceneAction(size_t matchIdx, const PmReaction &reaction,
-        bool switchedOn, size_t &sceneReactionIdx);
-    void switchScene(const std::string &targetSceneName,
-        const std::string &targetTransition);
+        const PmActionPlan &plan, PmToggleBatch &toggles);
+    void switchScene(const PmSceneTarget &target);
+    void updateCurrentScene();
 
     void pmSave(obs_data_t *data);
     void pmLoad(obs_data_t *data);
@@ -209,6 +253,8 @@ protected:
     bool m_periodicUpdateActive = false;
     QPointer<PmDialog> m_dialog = nullptr;
     QTimer* m_periodicUpdateTimer = nullptr;
+    QTimer* m_deadlineTimer = nullptr;
+    QTimer* m_editTimer = nullptr;
 
     mutable QRecursiveMutex m_pmFilterMutex;
     PmFilterRef m_activeFilter;
@@ -219,23 +265,58 @@ protected:
     PmSourceHash m_filters;
     PmSourceHash m_audioSources;
 
-    PmLingerQueue m_sceneLingerQueue;
-    PmLingerList m_lingerList;
-    PmLingerList m_cooldownList;
-    QSet<size_t> m_expiredLingers;
+    // scene graph is rescanned when OBS signals a change, and now and then
+    // to make sure nothing was missed
+    std::atomic<bool> m_sceneGraphDirty{true};
+    uint64_t m_lastSceneScanNs = 0;
+
+    PmDecisionEngine m_decisionEngine;
+    PmDecisionList m_decisions;
+    PmActionExecutor m_actionExecutor;
+    PmFileWriter m_fileWriter;
+
+    // image decodes in flight, by filename; only touched on the core thread
+    struct PmImageLoad
+    {
+        uint64_t serial = 0;
+        QFuture<PmDecodedImage> future;
+    };
+    PmImageIo m_imageIo;
+    PmImageStore m_imageStore;
+    QHash<std::string, PmImageLoad> m_imageLoads;
+    uint64_t m_imageLoadSerial = 0;
     bool m_forceSceneItemRefresh = true;
 
     QHash<std::string, OBSWeakSource> m_availableTransitions;
 
+    mutable QMutex m_currentSceneMutex;
+    OBSWeakSource m_currentScene;
+
     mutable QRecursiveMutex m_matchConfigMutex;
     PmMultiMatchConfig m_multiMatchConfig;
+    PmMultiMatchHash m_multiMatchHash; // follows m_multiMatchConfig
+    std::map<size_t, PmMatchConfig> m_pendingEdits;
     size_t m_selectedMatchIndex = 0;
+    PmCompiledConfigPtr m_compiledConfig
+        = std::make_shared<const PmCompiledConfig>();
     
     std::string m_activeMatchPreset;
-    PmMatchPresets m_matchPresets;
+    // every preset has a parsed config, a saved obs_data or both; presets
+    // from the scene collection are parsed when first needed, and a saved
+    // object is dropped whenever its preset changes, then rebuilt on save
+    mutable PmMatchPresets m_matchPresets;
+    QHash<std::string, OBSData> m_savedPresets;
+    mutable QHash<std::string, size_t> m_presetHashes;
+
+    // pack being imported; its images are extracted once presets are added,
+    // and the file is closed when the import is finished
+    std::shared_ptr<PmPresetPack> m_importPack;
+    std::string m_importPackDir;
 
     mutable QMutex m_resultsMutex;
     PmMultiMatchResults m_results;
+    PmResultsRing m_resultsRing;
+    PmMultiMatchResults m_nextResults;
 
     mutable QMutex m_previewConfigMutex;
     PmPreviewConfig m_previewConfig;
@@ -46,6 +46,16 @@ PmDebugTab::PmDebugTab(
     m_matchCountDisplay->setSizePolicy(minimumPolicy);
     mainLayout->addRow("Number Matched: ", m_matchCountDisplay);
 
+    // results frames skipped by the core
+    m_framesDroppedDisplay = new QLabel("--", this);
+    m_framesDroppedDisplay->setSizePolicy(minimumPolicy);
+    mainLayout->addRow("Frames Dropped: ", m_framesDroppedDisplay);
+
+    // reaction actions waiting for or running on the executor
+    m_actionQueueDisplay = new QLabel("--", this);
+    m_actionQueueDisplay->setSizePolicy(minimumPolicy);
+    mainLayout->addRow("Action Queue: ", m_actionQueueDisplay);
+
     // capture state
     m_captureStateDisplay = new QLabel("--", this);
     m_captureStateDisplay->setSizePolicy(minimumPolicy);
@@ -118,7 +128,7 @@ void PmDebugTab::periodicUpdate()
         m_filterDataResDisplay->setText(oss.str().data());
 
         oss.str("");
-        oss << activeFilter.numMatched(0);
+        oss << m_core->matchResults(0).numMatched;
         m_matchCountDisplay->setText(oss.str().data());
     } else {
         m_sourceResDisplay->setText("--");
@@ -126,12 +136,25 @@ void PmDebugTab::periodicUpdate()
         m_matchCountDisplay->setText("--");
     }
 
+    oss.str("");
+    oss << m_core->framesDropped() << " of " << m_core->framesProduced()
+        << " (" << m_core->framesStale() << " stale wakeups)";
+    m_framesDroppedDisplay->setText(oss.str().data());
+
+    {
+        const PmActionExecutor &executor = m_core->actionExecutor();
+        oss.str("");
+        oss << executor.queueDepth() << " (max " << executor.maxQueueDepth()
+            << "), " << executor.numExecuted() << " executed, "
+            << executor.avgExecNs() / 1000 << " us avg, "
+            << executor.maxExecNs() / 1000 << " us max";
+        m_actionQueueDisplay->setText(oss.str().data());
+    }
+
     {
         QString filterModeStr;
         if (fi.isValid()) {
-            fi.lockData();
-            auto filterMode = fi.filterData()->filter_mode;
-            fi.unlockData();
+            auto filterMode = pm_get_filter_mode(fi.filterData());
 
             switch (filterMode) {
             case PM_MATCH: filterModeStr = "PM_MATCH"; break;
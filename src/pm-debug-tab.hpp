@@ -26,6 +26,8 @@ private:
     QLabel *m_sourceResDisplay;
     QLabel *m_filterDataResDisplay;
     QLabel *m_matchCountDisplay;
+    QLabel *m_framesDroppedDisplay;
+    QLabel *m_actionQueueDisplay;
     QLabel* m_captureStateDisplay;
     QLabel* m_previewModeDisplay;
     QTextEdit *m_textDisplay;
@@ -0,0 +1,322 @@
+#include "pm-decision-engine.hpp"
+
+#include <algorithm>
+#include <functional>
+
+const size_t PmDecision::k_global;
+const uint64_t PmDecisionEngine::k_noDeadline;
+
+static const uint64_t k_nsPerMs = 1000000;
+
+void PmDecisionEngine::reset()
+{
+    m_matched.clear();
+    m_lingerEnd.clear();
+    m_sceneLinger.clear();
+    m_cooldownEnd.clear();
+    m_lingerExpired.clear();
+    m_lingerGen.clear();
+    m_cooldownGen.clear();
+    m_deadlines.clear();
+}
+
+void PmDecisionEngine::clearLingers()
+{
+    for (size_t i = 0; i < m_lingerEnd.size(); ++i) {
+        if (m_lingerEnd[i] != k_noDeadline)
+            setDeadline(PmDeadline::Linger, i, k_noDeadline);
+    }
+    std::fill(m_sceneLinger.begin(), m_sceneLinger.end(), 0);
+}
+
+bool PmDecisionEngine::isLingering(size_t matchIdx) const
+{
+    return matchIdx < m_lingerEnd.size()
+        && m_lingerEnd[matchIdx] != k_noDeadline;
+}
+
+bool PmDecisionEngine::isCoolingDown(size_t matchIdx) const
+{
+    return matchIdx < m_cooldownEnd.size()
+        && m_cooldownEnd[matchIdx] != k_noDeadline;
+}
+
+void PmDecisionEngine::resize(size_t sz)
+{
+    m_matched.resize(sz, 0);
+    m_lingerEnd.resize(sz, k_noDeadline);
+    m_sceneLinger.resize(sz, 0);
+    m_cooldownEnd.resize(sz, k_noDeadline);
+    m_lingerExpired.resize(sz, 0);
+    m_lingerGen.resize(sz, 0);
+    m_cooldownGen.resize(sz, 0);
+}
+
+void PmDecisionEngine::setDeadline(
+    PmDeadline::Kind kind, size_t matchIdx, uint64_t timeNs)
+{
+    // a previous deadline of the same kind stays in the heap, but won't
+    // match the generation anymore
+    bool linger = (kind == PmDeadline::Linger);
+    uint32_t gen = ++(linger ? m_lingerGen : m_cooldownGen)[matchIdx];
+    (linger ? m_lingerEnd : m_cooldownEnd)[matchIdx] = timeNs;
+    if (timeNs == k_noDeadline)
+        return;
+
+    m_deadlines.push_back({timeNs, matchIdx, gen, kind});
+    std::push_heap(m_deadlines.begin(), m_deadlines.end(),
+                   std::greater<PmDeadline>());
+}
+
+uint64_t PmDecisionEngine::nextDeadline()
+{
+    // stale deadlines on top are dropped so they don't cause wakeups
+    while (m_deadlines.size()) {
+        const PmDeadline &top = m_deadlines.front();
+        const auto &gens = (top.kind == PmDeadline::Linger)
+            ? m_lingerGen : m_cooldownGen;
+        if (top.matchIdx < gens.size() && gens[top.matchIdx] == top.generation)
+            return top.timeNs;
+        std::pop_heap(m_deadlines.begin(), m_deadlines.end(),
+                      std::greater<PmDeadline>());
+        m_deadlines.pop_back();
+    }
+    return k_noDeadline;
+}
+
+size_t PmDecisionEngine::firstSceneLinger() const
+{
+    // lingering scene reactions are prioritized by match index
+    for (size_t i = 0; i < m_sceneLinger.size(); ++i) {
+        if (m_sceneLinger[i])
+            return i;
+    }
+    return (size_t)-1;
+}
+
+void PmDecisionEngine::expireDeadlines(const PmCompiledConfig &cc,
+    uint64_t timeNs, PmDecisionList &decisions)
+{
+    std::fill(m_lingerExpired.begin(), m_lingerExpired.end(), 0);
+
+    // deadlines expire in the order they were due
+    uint64_t next;
+    while ((next = nextDeadline()) <= timeNs) {
+        PmDeadline deadline = m_deadlines.front();
+        std::pop_heap(m_deadlines.begin(), m_deadlines.end(),
+                      std::greater<PmDeadline>());
+        m_deadlines.pop_back();
+        size_t i = deadline.matchIdx;
+
+        if (deadline.kind == PmDeadline::Cooldown) {
+            // expired cooldowns disappear
+            setDeadline(PmDeadline::Cooldown, i, k_noDeadline);
+            decisions.push_back(
+                {PmDecisionType::CooldownActive, i, false, nullptr});
+        } else {
+            // expired lingers disappear, allowing other scenes; cooldowns start
+            setDeadline(PmDeadline::Linger, i, k_noDeadline);
+            m_sceneLinger[i] = 0;
+            m_lingerExpired[i] = 1;
+            decisions.push_back(
+                {PmDecisionType::LingerActive, i, false, nullptr});
+
+            uint32_t cooldownMs = i < cc.size() ? cc.cooldownMs[i] : 0;
+            if (cooldownMs > 0) {
+                setDeadline(PmDeadline::Cooldown, i,
+                            deadline.timeNs + cooldownMs * k_nsPerMs);
+                decisions.push_back(
+                    {PmDecisionType::CooldownActive, i, true, nullptr});
+            }
+        }
+    }
+}
+
+void PmDecisionEngine::process(
+    const PmCompiledConfig &cc, PmMultiMatchResults &results,
+    uint64_t timeNs, bool switchingEnabled, PmDecisionList &decisions)
+{
+    decisions.clear();
+    if (results.size() > m_matched.size())
+        resize(results.size());
+
+    expireDeadlines(cc, timeNs, decisions);
+
+    // scene reaction index gets determined to select/maintain just one target scene
+    m_sceneReactionIdx = firstSceneLinger();
+
+    bool anythingWasMatched = false;
+    bool anythingIsMatched = false;
+
+    for (uint8_t matched : m_matched) {
+        if (matched) {
+            anythingWasMatched = true;
+            break;
+        }
+    }
+
+    for (size_t matchIndex = 0; matchIndex < results.size(); matchIndex++) {
+        // assign match state
+        auto &result = results[matchIndex];
+        bool wasMatched = m_matched[matchIndex];
+        if (matchIndex >= cc.size()) {
+            // config for this entry isn't compiled yet
+            result.isMatched = false;
+            m_matched[matchIndex] = 0;
+            continue;
+        }
+        if (result.isReady) {
+            result.percentageMatched = float(result.numMatched)
+                / float(result.numCompared) * 100.f;
+            result.isMatched
+                = result.percentageMatched >= cc.totalMatchThresh[matchIndex];
+            if (cc.invertResult[matchIndex])
+                result.isMatched = !result.isMatched;
+        } else {
+            // match image is still being uploaded by the filter; hold on to
+            // the previous state until the entry can be evaluated
+            result.isMatched = wasMatched;
+        }
+
+        if (!switchingEnabled || !cc.isEnabled[matchIndex]
+         || !cc.hasReaction[matchIndex]) {
+            // no reaction necessary
+            m_matched[matchIndex] = result.isMatched;
+            continue;
+        }
+
+        bool isMatched = result.isMatched;
+        bool coolingDown = m_cooldownEnd[matchIndex] != k_noDeadline;
+
+        if (!wasMatched && isMatched && coolingDown) {
+            // prevent "switching on" after a cooldown
+            result.isMatched = false;
+            isMatched = false;
+        } else if (!isMatched && m_lingerExpired[matchIndex]) {
+            // emulate matched -> unmatched when a linger expires
+            wasMatched = true;
+        }
+        m_matched[matchIndex] = result.isMatched;
+
+        // has anything at all matched?
+        anythingIsMatched |= isMatched;
+
+        // "match changed" will trigger match/unmatch reactions
+        if (isMatched != wasMatched) {
+            // trigger match/unmatch reactions (or activate lingers)
+            react(cc, matchIndex, timeNs, isMatched, decisions);
+        }
+
+        if ((m_sceneReactionIdx == (size_t)-1
+          || matchIndex < m_sceneReactionIdx)
+         && cc.hasSceneAction[matchIndex]
+         && m_cooldownEnd[matchIndex] == k_noDeadline) {
+            // possible scene actions are always evaluated until target scene is found
+            bool isOn = isMatched || m_lingerEnd[matchIndex] != k_noDeadline;
+            sceneAction(cc, matchIndex, isOn);
+        }
+    }
+
+    // entries beyond the results don't exist anymore
+    if (m_matched.size() > results.size()) {
+        for (size_t i = results.size(); i < m_matched.size(); ++i) {
+            setDeadline(PmDeadline::Linger, i, k_noDeadline);
+            setDeadline(PmDeadline::Cooldown, i, k_noDeadline);
+        }
+        resize(results.size());
+    }
+
+    if (switchingEnabled) {
+        if (anythingWasMatched != anythingIsMatched) {
+            // independent anything/nothing match actions
+            decisions.push_back({PmDecisionType::RunActions,
+                PmDecision::k_global, anythingIsMatched, nullptr});
+        }
+
+        // finalize target scene evaluation
+        const PmSceneTarget *target;
+        size_t idx = m_sceneReactionIdx;
+        if (idx < cc.size()) {
+            if (m_lingerEnd[idx] != k_noDeadline || results[idx].isMatched) {
+                // match scene reaction entry
+                target = &cc.matchScene[idx];
+            } else {
+                target = &cc.unmatchScene[idx];
+            }
+        } else {
+            target = anythingIsMatched
+                ? &cc.globalMatchScene : &cc.globalUnmatchScene;
+        }
+        decisions.push_back(
+            {PmDecisionType::SwitchScene, idx, true, target});
+    }
+}
+
+void PmDecisionEngine::react(const PmCompiledConfig &cc, size_t matchIdx,
+    uint64_t timeNs, bool switchedOn, PmDecisionList &decisions)
+{
+    bool actionsTaken = false;
+    bool lingerActivated = false;
+
+    if (switchedOn) {
+        // undo any linger status for anything switched on
+        m_sceneLinger[matchIdx] = 0;
+        if (m_lingerEnd[matchIdx] != k_noDeadline) {
+            setDeadline(PmDeadline::Linger, matchIdx, k_noDeadline);
+            decisions.push_back(
+                {PmDecisionType::LingerActive, matchIdx, false, nullptr});
+        }
+    }
+
+    if (!switchedOn && cc.lingerMs[matchIdx] > 0
+     && !m_lingerExpired[matchIdx]) {
+        // activate linger
+        lingerActivated = true;
+        setDeadline(PmDeadline::Linger, matchIdx,
+                    timeNs + cc.lingerMs[matchIdx] * k_nsPerMs);
+        if (cc.hasMatchSceneAction[matchIdx])
+            m_sceneLinger[matchIdx] = 1;
+        decisions.push_back(
+            {PmDecisionType::LingerActive, matchIdx, true, nullptr});
+    }
+
+    if (!lingerActivated) {
+        // independent match/unmatch actions
+        if (switchedOn ? cc.hasSetMatchActions[matchIdx]
+                       : cc.hasSetUnmatchActions[matchIdx]) {
+            decisions.push_back(
+                {PmDecisionType::RunActions, matchIdx, switchedOn, nullptr});
+            actionsTaken = true;
+        }
+        // scene match/unmatch actions
+        if (sceneAction(cc, matchIdx, switchedOn)) {
+            actionsTaken = true;
+        }
+        // activate cooldown; after a linger, it already started when the
+        // linger expired
+        if (actionsTaken && !switchedOn && cc.cooldownMs[matchIdx] > 0
+         && !m_lingerExpired[matchIdx]) {
+            setDeadline(PmDeadline::Cooldown, matchIdx,
+                        timeNs + cc.cooldownMs[matchIdx] * k_nsPerMs);
+            decisions.push_back(
+                {PmDecisionType::CooldownActive, matchIdx, true, nullptr});
+        }
+    }
+}
+
+bool PmDecisionEngine::sceneAction(
+    const PmCompiledConfig &cc, size_t matchIdx, bool switchedOn)
+{
+    // higher priority scene is active ? => don't switch
+    if (m_sceneReactionIdx != (size_t)-1 && matchIdx > m_sceneReactionIdx)
+        return false;
+
+    // nothing to switch to, or the scene doesn't exist?
+    const PmSceneTarget &target = switchedOn
+        ? cc.matchScene[matchIdx] : cc.unmatchScene[matchIdx];
+    if (!target.sceneExists)
+        return false;
+
+    m_sceneReactionIdx = matchIdx;
+    return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "pm-compiled-config.hpp"
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * @brief Kinds of decisions made by PmDecisionEngine
+ */
+enum class PmDecisionType : int
+{
+    LingerActive,
+    CooldownActive,
+    RunActions,
+    SwitchScene,
+};
+
+/**
+ * @brief An outcome of one frame's evaluation, to be carried out by PmCore
+ */
+struct PmDecision
+{
+    static const size_t k_global = (size_t)-1;
+
+    PmDecisionType type;
+    size_t matchIdx; // k_global for the no-match reaction
+    bool on; // switched on, or linger/cooldown activated
+    const PmSceneTarget *sceneTarget; // for SwitchScene only
+};
+
+typedef std::vector<PmDecision> PmDecisionList;
+
+/**
+ * @brief Linger or cooldown deadline of a match entry. Entries made stale
+ *        by a later change of the same deadline are skipped by generation.
+ */
+struct PmDeadline
+{
+    enum Kind : uint8_t { Linger, Cooldown };
+
+    uint64_t timeNs;
+    size_t matchIdx;
+    uint32_t generation;
+    Kind kind;
+
+    bool operator>(const PmDeadline &other) const
+        { return timeNs > other.timeNs; }
+};
+
+/**
+ * @brief Turns frame results into match states and reactions: decides
+ *        what is matched, tracks lingers and cooldowns, and picks the scene
+ *        to switch to. Doesn't call into OBS or Qt; the same inputs and
+ *        timestamps always produce the same decisions.
+ */
+class PmDecisionEngine
+{
+public:
+    PmDecisionEngine() {}
+
+    void process(const PmCompiledConfig &cc, PmMultiMatchResults &results,
+        uint64_t timeNs, bool switchingEnabled, PmDecisionList &decisions);
+    uint64_t nextDeadline();
+
+    void reset();
+    void clearLingers();
+
+    size_t size() const { return m_matched.size(); }
+    bool isLingering(size_t matchIdx) const;
+    bool isCoolingDown(size_t matchIdx) const;
+
+protected:
+    static const uint64_t k_noDeadline = UINT64_MAX;
+
+    void resize(size_t sz);
+    void setDeadline(PmDeadline::Kind kind, size_t matchIdx, uint64_t timeNs);
+    void expireDeadlines(const PmCompiledConfig &cc,
+        uint64_t timeNs, PmDecisionList &decisions);
+    void react(const PmCompiledConfig &cc, size_t matchIdx, uint64_t timeNs,
+        bool switchedOn, PmDecisionList &decisions);
+    bool sceneAction(const PmCompiledConfig &cc, size_t matchIdx,
+        bool switchedOn);
+    size_t firstSceneLinger() const;
+
+    // per-entry state, indexed by match index
+    std::vector<uint8_t> m_matched;
+    std::vector<uint64_t> m_lingerEnd;
+    std::vector<uint8_t> m_sceneLinger;
+    std::vector<uint64_t> m_cooldownEnd;
+    std::vector<uint8_t> m_lingerExpired;
+    std::vector<uint32_t> m_lingerGen;
+    std::vector<uint32_t> m_cooldownGen;
+
+    // min-heap of all linger and cooldown deadlines
+    std::vector<PmDeadline> m_deadlines;
+
+    // per-frame state
+    size_t m_sceneReactionIdx = (size_t)-1;
+};
@@ -170,7 +170,8 @@ void PmDialog::onCaptureStateChanged(PmCaptureState state, int x, int y)
 
 void PmDialog::onMatchImageCaptured(QImage matchImg, int roiLeft, int roiBottom)
 {
-    PmMatchImageDialog* mid = new PmMatchImageDialog(matchImg, this);
+    PmMatchImageDialog* mid = new PmMatchImageDialog(
+        m_core->imageIo(), matchImg, this);
     mid->exec();
 
     if (mid->result() == QDialog::Accepted) {
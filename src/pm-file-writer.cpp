@@ -0,0 +1,145 @@
+#include "pm-file-writer.hpp"
+
+#include <QThread>
+
+#include <climits>
+
+#include <obs-module.h>
+#include <util/platform.h>
+
+const int PmFileWriter::k_flushBytes;
+const int PmFileWriter::k_flushIntervalMs;
+const int PmFileWriter::k_idleCloseMs;
+
+static const uint64_t k_nsPerMs = 1000000;
+
+PmFileWriter::PmFileWriter()
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("pixel match file writer");
+    m_thread->start();
+}
+
+PmFileWriter::~PmFileWriter()
+{
+    stop();
+    delete m_thread;
+}
+
+void PmFileWriter::write(
+    const std::string &filename, bool truncate, std::string line)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stopping)
+        return;
+    m_requests.push_back({filename, truncate, std::move(line)});
+    m_wakeUp.wakeOne();
+}
+
+void PmFileWriter::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wakeUp.wakeOne();
+    }
+    m_thread->wait();
+}
+
+void PmFileWriter::run()
+{
+    std::vector<Request> requests;
+    bool stopping = false;
+
+    while (!stopping) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_requests.empty() && !m_stopping) {
+                // nothing buffered: sleep until the next write
+                unsigned long waitMs = m_files.empty()
+                    ? ULONG_MAX : (unsigned long)k_flushIntervalMs;
+                m_wakeUp.wait(&m_mutex, waitMs);
+            }
+            requests.swap(m_requests);
+            stopping = m_stopping;
+        }
+
+        uint64_t timeNs = os_gettime_ns();
+        for (const Request &request : requests) {
+            append(request, timeNs);
+        }
+        requests.clear();
+
+        // flush what's big or old enough; close files that went idle
+        for (auto it = m_files.begin(); it != m_files.end();) {
+            OpenFile &openFile = *it->second;
+            if (stopping
+             || openFile.buffer.size() >= k_flushBytes
+             || timeNs - openFile.firstBufferedNs
+                    >= uint64_t(k_flushIntervalMs) * k_nsPerMs) {
+                flush(openFile, timeNs);
+            }
+            bool idle = openFile.buffer.isEmpty()
+                && !openFile.truncatePending
+                && timeNs - openFile.lastWriteNs
+                    >= uint64_t(k_idleCloseMs) * k_nsPerMs;
+            if (stopping || idle) {
+                it = m_files.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void PmFileWriter::append(const Request &request, uint64_t timeNs)
+{
+    auto &openFile = m_files[request.filename];
+    if (!openFile) {
+        openFile.reset(new OpenFile);
+        openFile->file.setFileName(request.filename.data());
+        openFile->lastWriteNs = timeNs;
+    }
+
+    if (request.truncate) {
+        // anything not yet written would be truncated away anyway
+        openFile->buffer.clear();
+        openFile->truncatePending = true;
+    }
+    if (openFile->buffer.isEmpty())
+        openFile->firstBufferedNs = timeNs;
+    openFile->buffer.append(request.line.data(), int(request.line.size()));
+}
+
+void PmFileWriter::flush(OpenFile &openFile, uint64_t timeNs)
+{
+    if (openFile.buffer.isEmpty() && !openFile.truncatePending)
+        return;
+
+    QFile &file = openFile.file;
+    if (!file.isOpen()) {
+        file.open(QIODevice::WriteOnly | QIODevice::Append);
+        if (!file.isOpen()) {
+            // report once per failing file, until it opens again
+            if (!openFile.failed) {
+                blog(LOG_ERROR, "Error opening %s: %s",
+                     file.fileName().toUtf8().data(),
+                     file.errorString().toUtf8().data());
+                openFile.failed = true;
+            }
+            openFile.buffer.clear();
+            openFile.truncatePending = false;
+            return;
+        }
+        openFile.failed = false;
+    }
+
+    if (openFile.truncatePending) {
+        file.resize(0);
+        openFile.truncatePending = false;
+    }
+    file.write(openFile.buffer);
+    file.flush();
+    openFile.buffer.clear();
+    openFile.lastWriteNs = timeNs;
+}
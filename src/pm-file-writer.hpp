@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class QThread;
+
+/**
+ * @brief Writes lines for File actions on a dedicated thread. Files are kept
+ *        open between writes and lines are buffered per file, then flushed
+ *        when enough data has accumulated, when the oldest buffered line
+ *        gets too old, and when the writer is stopped.
+ */
+class PmFileWriter
+{
+public:
+    static const int k_flushBytes = 64 * 1024;
+    static const int k_flushIntervalMs = 1000;
+    static const int k_idleCloseMs = 30000;
+
+    PmFileWriter();
+    ~PmFileWriter();
+
+    // line is written as is; a truncating write replaces the file contents
+    void write(const std::string &filename, bool truncate, std::string line);
+    void stop();
+
+protected:
+    struct Request
+    {
+        std::string filename;
+        bool truncate;
+        std::string line;
+    };
+
+    struct OpenFile
+    {
+        QFile file;
+        QByteArray buffer;
+        bool truncatePending = false;
+        bool failed = false;
+        uint64_t firstBufferedNs = 0;
+        uint64_t lastWriteNs = 0;
+    };
+
+    void run();
+    void append(const Request &request, uint64_t timeNs);
+    void flush(OpenFile &openFile, uint64_t timeNs);
+
+    QThread *m_thread = nullptr;
+
+    // shared with the writer thread
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;
+    std::vector<Request> m_requests;
+    bool m_stopping = false;
+
+    // writer thread state
+    std::unordered_map<std::string, std::unique_ptr<OpenFile>> m_files;
+};
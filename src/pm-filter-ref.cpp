@@ -6,20 +6,6 @@ void PmFilterRef::setFilter(OBSWeakSource filter)
     m_filter = filter;
 }
 
-void PmFilterRef::lockData() const
-{
-    auto data = filterData();
-    if (data)
-        pthread_mutex_lock(&data->mutex);
-}
-
-void PmFilterRef::unlockData() const
-{
-    auto data = filterData();
-    if (data)
-        pthread_mutex_unlock(&data->mutex);
-}
-
 obs_source_t* PmFilterRef::filter() const
 {
     return obs_weak_source_get_source(m_filter); 
@@ -62,37 +48,11 @@ uint32_t PmFilterRef::filterSrcHeight() const
 uint32_t PmFilterRef::filterDataWidth() const
 {
     auto data = filterData();
-    uint32_t ret = 0;
-    if (data) {
-        lockData();
-        ret = data->base_width;
-        unlockData();
-    }
-    return ret;
+    return data ? pm_get_base_width(data) : 0;
 }
 
 uint32_t PmFilterRef::filterDataHeight() const
 {
     auto data = filterData();
-    uint32_t ret = 0;
-    if (data) {
-        lockData();
-        ret = data->base_height;
-        unlockData();
-    }
-    return ret;
-}
-
-uint32_t PmFilterRef::numMatched(size_t matchIndex) const
-{
-    auto data = filterData();
-    uint32_t ret = 0;
-    if (data) {
-        lockData();
-        if (matchIndex < data->num_match_entries) {
-            ret = data->match_entries[matchIndex].num_matched;
-        }
-        unlockData();
-    }
-    return ret;
+    return data ? pm_get_base_height(data) : 0;
 }
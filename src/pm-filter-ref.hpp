@@ -21,12 +21,9 @@ public:
     uint32_t filterSrcHeight() const;
     uint32_t filterDataWidth() const;
     uint32_t filterDataHeight() const;
-    uint32_t numMatched(size_t matchIndex) const;
 
     void reset();
     void setFilter(OBSWeakSource filter);
-    void lockData() const;
-    void unlockData() const;
 
 protected:
     OBSWeakSource m_filter;
@@ -2,6 +2,8 @@
 #include "pm-module.h"
 
 #include <graphics/graphics.h>
+#include <util/platform.h>
+#include <util/threading.h>
 
 #define PIXEL_MATCH_FILTER_DISPLAY_NAME obs_module_text("Pixel Match Filter")
 
@@ -9,6 +11,12 @@ const float PM_VISUALIZE_BORDER_THICKNESS = 2.f;
 const float PM_SELECT_REGION_BORDER_THICKNESS = 4.f;
 const float PM_AUTOMASK_BORDER_THICKNESS = 4.f;
 
+// how many bytes of match images may be uploaded within one frame
+const size_t PM_UPLOAD_FRAME_BUDGET = 4 * 1024 * 1024;
+
+// default size limit of the match texture cache
+const long long PM_DEFAULT_TEXTURE_CACHE_MB = 256;
+
 struct vec3 vec3_dummy;
 
 bool pm_filter_failed = false;
@@ -19,32 +27,408 @@ static const char *pixel_match_filter_get_name(void* unused)
     return PIXEL_MATCH_FILTER_DISPLAY_NAME;
 }
 
+struct pm_texture_cache_entry* find_cached_texture(
+    struct pm_filter_data* filter, uint64_t hash,
+    uint32_t width, uint32_t height)
+{
+    // the hash alone could collide between images of different sizes
+    for (size_t i = 0; i < filter->tex_cache_size; ++i) {
+        struct pm_texture_cache_entry* cached = filter->tex_cache + i;
+        if (cached->hash == hash
+         && cached->width == width && cached->height == height)
+            return cached;
+    }
+    return NULL;
+}
+
+void release_cached_texture(
+    struct pm_filter_data* filter, struct pm_match_entry_data* entry)
+{
+    if (!entry->match_img_tex)
+        return;
+
+    for (size_t i = 0; i < filter->tex_cache_size; ++i) {
+        struct pm_texture_cache_entry* cached = filter->tex_cache + i;
+        if (cached->tex == entry->match_img_tex) {
+            if (cached->ref_count > 0)
+                cached->ref_count--;
+            cached->last_used = ++filter->tex_cache_clock;
+            break;
+        }
+    }
+    entry->match_img_tex = NULL;
+    entry->is_ready = false;
+}
+
+void attach_cached_texture(struct pm_filter_data* filter,
+    struct pm_match_entry_data* entry, struct pm_texture_cache_entry* cached)
+{
+    release_cached_texture(filter, entry);
+
+    cached->ref_count++;
+    cached->last_used = ++filter->tex_cache_clock;
+    entry->match_img_tex = cached->tex;
+    entry->match_img_width = cached->width;
+    entry->match_img_height = cached->height;
+    entry->is_ready = true;
+}
+
+struct pm_texture_cache_entry* insert_cached_texture(
+    struct pm_filter_data* filter, uint64_t hash,
+    uint32_t width, uint32_t height, gs_texture_t* tex)
+{
+    if (filter->tex_cache_size == filter->tex_cache_capacity) {
+        size_t new_capacity = filter->tex_cache_capacity
+            ? filter->tex_cache_capacity * 2 : 16;
+        filter->tex_cache = (struct pm_texture_cache_entry*)brealloc(
+            filter->tex_cache,
+            sizeof(struct pm_texture_cache_entry) * new_capacity);
+        filter->tex_cache_capacity = new_capacity;
+    }
+
+    struct pm_texture_cache_entry* cached
+        = filter->tex_cache + filter->tex_cache_size++;
+    cached->hash = hash;
+    cached->width = width;
+    cached->height = height;
+    cached->tex = tex;
+    cached->ref_count = 0;
+    cached->last_used = ++filter->tex_cache_clock;
+    filter->tex_cache_bytes += (size_t)width * (size_t)height * 4;
+    return cached;
+}
+
+void evict_cached_textures(struct pm_filter_data* filter)
+{
+    // least recently released textures go first; textures that are in use
+    // are never evicted, even when the budget is exceeded
+    while (filter->tex_cache_bytes > filter->tex_cache_budget) {
+        struct pm_texture_cache_entry* lru = NULL;
+        for (size_t i = 0; i < filter->tex_cache_size; ++i) {
+            struct pm_texture_cache_entry* cached = filter->tex_cache + i;
+            if (cached->ref_count == 0
+             && (!lru || cached->last_used < lru->last_used)) {
+                lru = cached;
+            }
+        }
+        if (!lru)
+            break;
+
+        gs_texture_destroy(lru->tex);
+        filter->tex_cache_bytes
+            -= (size_t)lru->width * (size_t)lru->height * 4;
+        *lru = filter->tex_cache[--filter->tex_cache_size];
+    }
+}
+
+void destroy_texture_cache(struct pm_filter_data* filter)
+{
+    for (size_t i = 0; i < filter->tex_cache_size; ++i) {
+        gs_texture_destroy(filter->tex_cache[i].tex);
+    }
+    if (filter->tex_cache)
+        bfree(filter->tex_cache);
+    filter->tex_cache = NULL;
+    filter->tex_cache_size = filter->tex_cache_capacity = 0;
+    filter->tex_cache_bytes = 0;
+}
+
+void reserve_config_entries(struct pm_filter_config* fc, size_t size)
+{
+    if (fc->match_entries_capacity < size) {
+        fc->match_entries = (struct pm_match_entry_config*)brealloc(
+            fc->match_entries, sizeof(struct pm_match_entry_config) * size);
+        fc->match_handles = (struct pm_entry_handle*)brealloc(
+            fc->match_handles, sizeof(struct pm_entry_handle) * size);
+        fc->match_entries_capacity = size;
+    }
+}
+
+void copy_filter_config(
+    struct pm_filter_config* dst, const struct pm_filter_config* src)
+{
+    reserve_config_entries(dst, src->num_match_entries);
+    if (src->num_match_entries > 0) {
+        memcpy(dst->match_entries, src->match_entries,
+            sizeof(struct pm_match_entry_config) * src->num_match_entries);
+        memcpy(dst->match_handles, src->match_handles,
+            sizeof(struct pm_entry_handle) * src->num_match_entries);
+    }
+    dst->num_match_entries = src->num_match_entries;
+    dst->entries_version = src->entries_version;
+    dst->selected_match_index = src->selected_match_index;
+    dst->select_left = src->select_left;
+    dst->select_bottom = src->select_bottom;
+    dst->select_right = src->select_right;
+    dst->select_top = src->select_top;
+    dst->on_match_image_captured = src->on_match_image_captured;
+    dst->on_frame_processed = src->on_frame_processed;
+}
+
+struct pm_filter_config* config_write_begin(struct pm_filter_data* filter)
+{
+    pthread_mutex_lock(&filter->config_mutex);
+
+    // only writers change the published index, so the other copy can't
+    // become visible to the render thread until config_write_end(); a frame
+    // that is still reading it from before the last swap is waited out
+    long idx = os_atomic_load_long(&filter->config_published) ^ 1;
+    while (os_atomic_load_long(&filter->config_reading) == idx)
+        os_sleep_ms(1);
+
+    struct pm_filter_config* cfg = filter->configs + idx;
+    copy_filter_config(cfg, filter->configs + (idx ^ 1));
+    return cfg;
+}
+
+void config_write_end(struct pm_filter_data* filter)
+{
+    long idx = os_atomic_load_long(&filter->config_published) ^ 1;
+    os_atomic_set_long(&filter->config_published, idx);
+    pthread_mutex_unlock(&filter->config_mutex);
+}
+
+const struct pm_filter_config* config_read_begin(struct pm_filter_data* filter)
+{
+    // announce the copy before using it, then make sure it wasn't swapped
+    // out in the meantime; never blocks
+    long idx;
+    do {
+        idx = os_atomic_load_long(&filter->config_published);
+        os_atomic_set_long(&filter->config_reading, idx);
+    } while (idx != os_atomic_load_long(&filter->config_published));
+    return filter->configs + idx;
+}
+
+void config_read_end(struct pm_filter_data* filter)
+{
+    os_atomic_set_long(&filter->config_reading, -1);
+    filter->frame_config = NULL;
+}
+
+void free_image_data(struct pm_image_data* data)
+{
+    if (data->release) {
+        data->release(data->opaque);
+    } else if (data->pixels) {
+        bfree(data->pixels);
+    }
+    memset((void *)data, 0, sizeof(struct pm_image_data));
+}
+
+void unpin_pending_image(
+    struct pm_filter_data* filter, struct pm_pending_image* pending)
+{
+    // render thread only, like every other change of reference counts
+    if (!pending->pinned_tex)
+        return;
+
+    for (size_t i = 0; i < filter->tex_cache_size; ++i) {
+        struct pm_texture_cache_entry* cached = filter->tex_cache + i;
+        if (cached->tex == pending->pinned_tex) {
+            if (cached->ref_count > 0)
+                cached->ref_count--;
+            cached->last_used = ++filter->tex_cache_clock;
+            break;
+        }
+    }
+    pending->pinned_tex = NULL;
+}
+
+void reset_match_entry(struct pm_filter_data* filter,
+    struct pm_match_entry_data* entry, uint32_t generation)
+{
+    // textures stay cached for when they're needed again
+    release_cached_texture(filter, entry);
+    free_image_data(&entry->match_img_data);
+    memset((void *)entry, 0, sizeof(struct pm_match_entry_data));
+    entry->generation = generation;
+}
+
+void sync_match_entries(struct pm_filter_data* filter)
+{
+    // entries keep their pool slot while they're moved around, so only
+    // new and removed entries have their textures attached or released
+    const struct pm_filter_config* cfg = filter->frame_config;
+    if (cfg->entries_version == filter->synced_entries_version)
+        return;
+
+    size_t num_entries = cfg->num_match_entries;
+    size_t pool_size = filter->entry_pool_size;
+    for (size_t i = 0; i < num_entries; ++i) {
+        if (cfg->match_handles[i].slot >= pool_size)
+            pool_size = cfg->match_handles[i].slot + 1;
+    }
+    if (pool_size > filter->entry_pool_size) {
+        filter->entry_pool = (struct pm_match_entry_data *)brealloc(
+            filter->entry_pool,
+            sizeof(struct pm_match_entry_data) * pool_size);
+        memset((void *)(filter->entry_pool + filter->entry_pool_size), 0,
+               sizeof(struct pm_match_entry_data)
+                   * (pool_size - filter->entry_pool_size));
+        filter->entry_pool_size = pool_size;
+    }
+    if (num_entries > filter->match_entries_capacity) {
+        filter->match_entries = (struct pm_match_entry_data **)brealloc(
+            filter->match_entries,
+            sizeof(struct pm_match_entry_data *) * num_entries);
+        filter->match_entries_capacity = num_entries;
+    }
+
+    for (size_t i = 0; i < filter->entry_pool_size; ++i) {
+        filter->entry_pool[i].in_config = false;
+    }
+    for (size_t i = 0; i < num_entries; ++i) {
+        struct pm_entry_handle handle = cfg->match_handles[i];
+        struct pm_match_entry_data* entry = filter->entry_pool + handle.slot;
+        if (entry->generation != handle.generation) {
+            // slot went to a new entry since the last sync
+            reset_match_entry(filter, entry, handle.generation);
+        }
+        entry->in_config = true;
+        filter->match_entries[i] = entry;
+    }
+    for (size_t i = 0; i < filter->entry_pool_size; ++i) {
+        struct pm_match_entry_data* entry = filter->entry_pool + i;
+        if (!entry->in_config
+         && (entry->match_img_tex || entry->match_img_data.pixels)) {
+            reset_match_entry(filter, entry, entry->generation);
+        }
+    }
+    filter->num_match_entries = num_entries;
+    filter->synced_entries_version = cfg->entries_version;
+}
+
+void take_pending_images(struct pm_filter_data* filter)
+{
+    // images of entries the render thread doesn't know about yet are left
+    // in the queue for a later frame
+    size_t kept = 0;
+    for (size_t i = 0; i < filter->num_pending_images; ++i) {
+        struct pm_pending_image* pending = filter->pending_images + i;
+        if (pending->dropped) {
+            unpin_pending_image(filter, pending);
+            free_image_data(&pending->data);
+            continue;
+        }
+
+        // a cache hit is pinned the first time it's seen here; eviction
+        // only runs after this, under the same lock, so the texture found
+        // at supply time is still there
+        if (pending->use_cache && !pending->pinned_tex) {
+            struct pm_texture_cache_entry* cached = find_cached_texture(
+                filter, pending->hash, pending->width, pending->height);
+            if (cached) {
+                cached->ref_count++;
+                pending->pinned_tex = cached->tex;
+            }
+        }
+
+        struct pm_entry_handle handle = pending->handle;
+        struct pm_match_entry_data* entry
+            = handle.slot < filter->entry_pool_size
+            ? filter->entry_pool + handle.slot : NULL;
+        if (!entry || (int32_t)(handle.generation - entry->generation) > 0) {
+            filter->pending_images[kept++] = *pending;
+            continue;
+        } else if (handle.generation != entry->generation) {
+            unpin_pending_image(filter, pending);
+            free_image_data(&pending->data);
+            continue;
+        }
+
+        entry->match_img_offset_left = pending->offset_left;
+        entry->match_img_offset_bottom = pending->offset_bottom;
+        free_image_data(&entry->match_img_data);
+
+        struct pm_texture_cache_entry* cached = pending->use_cache
+            ? find_cached_texture(filter, pending->hash,
+                                  pending->width, pending->height)
+            : NULL;
+        if (cached) {
+            // same image content is already on the GPU; the entry's
+            // reference replaces the one held while the image was queued
+            attach_cached_texture(filter, entry, cached);
+            unpin_pending_image(filter, pending);
+        } else {
+            // the entry is not evaluated until the new texture is uploaded
+            release_cached_texture(filter, entry);
+            entry->match_img_data = pending->data;
+            entry->match_img_hash = pending->hash;
+            entry->match_img_width = pending->width;
+            entry->match_img_height = pending->height;
+            unpin_pending_image(filter, pending);
+        }
+    }
+    filter->num_pending_images = kept;
+}
+
 static void pixel_match_filter_destroy(void *data)
 {
     struct pm_filter_data *filter = data;
 
-    pthread_mutex_lock(&filter->mutex);
-    pm_resize_match_entries(filter, 0);
+    for (size_t i = 0; i < filter->entry_pool_size; ++i) {
+        free_image_data(&filter->entry_pool[i].match_img_data);
+    }
+    if (filter->entry_pool)
+        bfree(filter->entry_pool);
+    if (filter->match_entries)
+        bfree(filter->match_entries);
+    if (filter->slot_generations)
+        bfree(filter->slot_generations);
+    if (filter->free_slots)
+        bfree(filter->free_slots);
+    for (size_t i = 0; i < filter->num_pending_images; ++i) {
+        free_image_data(&filter->pending_images[i].data);
+    }
+    if (filter->pending_images)
+        bfree(filter->pending_images);
+    for (size_t i = 0; i < 2; ++i) {
+        if (filter->configs[i].match_entries)
+            bfree(filter->configs[i].match_entries);
+        if (filter->configs[i].match_handles)
+            bfree(filter->configs[i].match_handles);
+    }
+
     obs_enter_graphics();
+    destroy_texture_cache(filter);
     if (filter->snapshot_texrender)
         gs_texrender_destroy(filter->snapshot_texrender);
     if (filter->snapshot_stagesurface)
         gs_stagesurface_destroy(filter->snapshot_stagesurface);
-    if (filter->mask_texrender)
-        gs_texrender_destroy(filter->mask_texrender);
+    if (filter->region_texrender)
+        gs_texrender_destroy(filter->region_texrender);
+    for (size_t i = 0; i < 2; ++i) {
+        if (filter->mask_texrender[i])
+            gs_texrender_destroy(filter->mask_texrender[i]);
+    }
     if (filter->mask_stagesurface)
         gs_stagesurface_destroy(filter->mask_stagesurface);
-    if (filter->mask_region_texture)
-        gs_texture_destroy(filter->mask_region_texture);
     gs_effect_destroy(filter->effect);
     obs_leave_graphics();
     if (filter->captured_region_data)
         bfree(filter->captured_region_data);
-    pthread_mutex_unlock(&filter->mutex);
-    pthread_mutex_destroy(&filter->mutex);
+    pthread_mutex_destroy(&filter->config_mutex);
+    pthread_mutex_destroy(&filter->upload_mutex);
     bfree(filter);
 }
 
+static void pixel_match_filter_update(void* data, obs_data_t* settings)
+{
+    struct pm_filter_data* filter = data;
+
+    pthread_mutex_lock(&filter->upload_mutex);
+    filter->tex_cache_budget = (size_t)obs_data_get_int(
+        settings, "texture_cache_mb") * 1024 * 1024;
+    pthread_mutex_unlock(&filter->upload_mutex);
+}
+
+static void pixel_match_filter_defaults(obs_data_t* settings)
+{
+    obs_data_set_default_int(
+        settings, "texture_cache_mb", PM_DEFAULT_TEXTURE_CACHE_MB);
+}
+
 static void *pixel_match_filter_create(
     obs_data_t *settings, obs_source_t *context)
 {
@@ -52,17 +436,9 @@ static void *pixel_match_filter_create(
     char *effect_path = obs_module_file("pixel_match.effect");
     filter->context = context;
 
-#if 1
-    // recursive mutex
-    pthread_mutexattr_t mutex_attr;
-    pthread_mutexattr_init(&mutex_attr);
-    pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
-    pthread_mutex_init(&filter->mutex, &mutex_attr);
-    pthread_mutexattr_destroy(&mutex_attr);
-#else
-    // non-recursive mutex
-    pthread_mutex_init(&filter->mutex, NULL);
-#endif
+    pthread_mutex_init(&filter->config_mutex, NULL);
+    pthread_mutex_init(&filter->upload_mutex, NULL);
+    filter->config_reading = -1;
 
     //  gfx init
     obs_enter_graphics();
@@ -123,7 +499,7 @@ static void *pixel_match_filter_create(
      || !filter->param_compare_counter || !filter->result_compare_counter)
         goto error;
 
-    //obs_source_update(context, settings);
+    pixel_match_filter_update(filter, settings);
     return filter;
 
 gfx_fail:
@@ -136,11 +512,11 @@ error:
     pm_filter_failed = true;
     return NULL;
 
-    UNUSED_PARAMETER(settings);
 }
 
 void render_select_region(struct pm_filter_data* filter)
 {
+    const struct pm_filter_config* cfg = filter->frame_config;
     // select region mode just displays a selection rectangle
         // TODO: move to a function
     if (!obs_source_process_filter_begin(
@@ -151,13 +527,13 @@ void render_select_region(struct pm_filter_data* filter)
     }
 
     float roi_left_u
-        = (float)(filter->select_left) / (float)(filter->base_width);
+        = (float)(cfg->select_left) / (float)(filter->base_width);
     float roi_bottom_v
-        = (float)(filter->select_bottom) / (float)(filter->base_height);
+        = (float)(cfg->select_bottom) / (float)(filter->base_height);
     float roi_right_u
-        = (float)(filter->select_right + 1) / (float)(filter->base_width);
+        = (float)(cfg->select_right + 1) / (float)(filter->base_width);
     float roi_top_v
-        = (float)(filter->select_top + 1) / (float)(filter->base_height);
+        = (float)(cfg->select_top + 1) / (float)(filter->base_height);
 
     // these values will be actually relevant to drawing a region selection
     gs_effect_set_float(filter->param_roi_left, roi_left_u);
@@ -200,20 +576,30 @@ void render_passthrough(struct pm_filter_data* filter)
 
 void render_match_entries(struct pm_filter_data* filter)
 {
+    const struct pm_filter_config* cfg = filter->frame_config;
     bool nothing_rendered = true;
 
     for (size_t i = 0; i < filter->num_match_entries; ++i) {
-        struct pm_match_entry_data* entry = filter->match_entries + i;
+        struct pm_match_entry_data* entry = filter->match_entries[i];
+        const struct pm_match_entry_config* entry_cfg
+            = cfg->match_entries + i;
+
+        if (!entry->is_ready) {
+            // texture isn't uploaded yet; skip until it is
+            entry->num_compared = 0;
+            entry->num_matched = 0;
+            continue;
+        }
 
-        if (filter->filter_mode == PM_MATCH_VISUALIZE) {
-            if (i != filter->selected_match_index) {
+        if (filter->frame_mode == PM_MATCH_VISUALIZE) {
+            if (i != cfg->selected_match_index) {
                 // visualize mode only renders the selected match entry
                 continue;
             } else {
                 nothing_rendered = false;
             }
         } else {
-            if (!entry->cfg.is_enabled) {
+            if (!entry_cfg->is_enabled) {
                 entry->num_compared = 0;
                 entry->num_matched = 0;
                 // disable entries are skipped in matching
@@ -221,19 +607,6 @@ void render_match_entries(struct pm_filter_data* filter)
             }
         }
 
-        if (entry->match_img_data
-            && entry->match_img_width
-            && entry->match_img_height) {
-            if (entry->match_img_tex)
-                gs_texture_destroy(entry->match_img_tex);
-            entry->match_img_tex = gs_texture_create(
-                entry->match_img_width, entry->match_img_height,
-                GS_BGRA, (uint8_t)-1,
-                (const uint8_t**)(&entry->match_img_data), 0);
-            bfree(entry->match_img_data);
-            entry->match_img_data = NULL;
-        }
-
         if (!obs_source_process_filter_begin(
             filter->context, GS_RGBA, OBS_NO_DIRECT_RENDERING)) {
             blog(LOG_ERROR,
@@ -242,14 +615,16 @@ void render_match_entries(struct pm_filter_data* filter)
         }
 
         float roi_left_u
-            = (float)(entry->cfg.roi_left) / (float)(filter->base_width);
+            = (float)(entry_cfg->roi_left + entry->match_img_offset_left)
+            / (float)(filter->base_width);
         float roi_bottom_v
-            = (float)(entry->cfg.roi_bottom) / (float)(filter->base_height);
+            = (float)(entry_cfg->roi_bottom + entry->match_img_offset_bottom)
+            / (float)(filter->base_height);
         float roi_right_u = roi_left_u
             + (float)(entry->match_img_width) / (float)(filter->base_width);
         float roi_top_v = roi_bottom_v
             + (float)(entry->match_img_height) / (float)(filter->base_height);
-        bool visualize = (filter->filter_mode == PM_MATCH_VISUALIZE);
+        bool visualize = (filter->frame_mode == PM_MATCH_VISUALIZE);
 
         gs_effect_set_atomic_uint(filter->param_compare_counter, 0);
         gs_effect_set_atomic_uint(filter->param_match_counter, 0);
@@ -258,10 +633,10 @@ void render_match_entries(struct pm_filter_data* filter)
         gs_effect_set_float(filter->param_roi_right, roi_right_u);
         gs_effect_set_float(filter->param_roi_top, roi_top_v);
         gs_effect_set_float(filter->param_per_pixel_err_thresh,
-            entry->cfg.per_pixel_err_thresh / 100.f);
-        gs_effect_set_bool(filter->param_mask_alpha, entry->cfg.mask_alpha);
+            entry_cfg->per_pixel_err_thresh / 100.f);
+        gs_effect_set_bool(filter->param_mask_alpha, entry_cfg->mask_alpha);
         gs_effect_set_bool(filter->param_store_match_alpha, false);
-        gs_effect_set_vec3(filter->param_mask_color, &entry->cfg.mask_color);
+        gs_effect_set_vec3(filter->param_mask_color, &entry_cfg->mask_color);
 
         const bool linear_srgb = gs_get_linear_srgb();
 
@@ -282,7 +657,7 @@ void render_match_entries(struct pm_filter_data* filter)
         obs_source_process_filter_end(filter->context, filter->effect,
             filter->base_width, filter->base_height);
 
-        if (filter->filter_mode == PM_MATCH) {
+        if (filter->frame_mode == PM_MATCH) {
             entry->num_compared =
                 gs_effect_get_atomic_uint_result(filter->result_compare_counter);
             entry->num_matched =
@@ -295,6 +670,50 @@ void render_match_entries(struct pm_filter_data* filter)
     }
 }
 
+void upload_match_textures(struct pm_filter_data* filter)
+{
+    // textures are created after the frame's matching work is done, and only
+    // within a byte budget, so that loading many images is spread over
+    // several frames; at least one image is uploaded per frame
+    size_t budget = PM_UPLOAD_FRAME_BUDGET;
+
+    for (size_t i = 0; i < filter->num_match_entries && budget > 0; ++i) {
+        struct pm_match_entry_data* entry = filter->match_entries[i];
+        if (!entry->match_img_data.pixels)
+            continue;
+
+        // another entry may have uploaded the same image in the meantime
+        struct pm_texture_cache_entry* cached
+            = find_cached_texture(filter, entry->match_img_hash,
+                entry->match_img_width, entry->match_img_height);
+        if (cached) {
+            attach_cached_texture(filter, entry, cached);
+            free_image_data(&entry->match_img_data);
+            continue;
+        }
+
+        size_t sz = (size_t)entry->match_img_width
+                  * (size_t)entry->match_img_height * 4;
+        if (sz > budget && budget < PM_UPLOAD_FRAME_BUDGET)
+            break;
+
+        gs_texture_t* tex = gs_texture_create(
+            entry->match_img_width, entry->match_img_height,
+            GS_BGRA, (uint8_t)-1,
+            (const uint8_t**)(&entry->match_img_data.pixels), 0);
+        free_image_data(&entry->match_img_data);
+        if (tex) {
+            cached = insert_cached_texture(filter, entry->match_img_hash,
+                entry->match_img_width, entry->match_img_height, tex);
+            attach_cached_texture(filter, entry, cached);
+        }
+
+        budget = (sz < budget) ? budget - sz : 0;
+    }
+
+    evict_cached_textures(filter);
+}
+
 bool stagerender_begin(
     struct pm_filter_data* filter,gs_stagesurf_t** sss, gs_texrender_t** stx)
 {
@@ -349,9 +768,10 @@ void copy_region_from_stagerender(
     gs_stagesurf_t* sss, gs_texrender_t* stx,
     uint8_t *dstPtr, uint32_t dstStride)
 {
+    const struct pm_filter_config* cfg = filter->frame_config;
     const size_t pixSz = 4;
     size_t height 
-        = (size_t)filter->select_top - (size_t)filter->select_bottom + 1;
+        = (size_t)cfg->select_top - (size_t)cfg->select_bottom + 1;
 
     gs_texture_t* tex = gs_texrender_get_texture(stx);
     gs_stage_texture(sss, tex);
@@ -363,8 +783,8 @@ void copy_region_from_stagerender(
     }
 
     uint8_t* srcPtr = stageSurfData
-        + (size_t)(filter->select_bottom) * srcStride 
-        + (size_t)(filter->select_left) * pixSz;
+        + (size_t)(cfg->select_bottom) * srcStride 
+        + (size_t)(cfg->select_left) * pixSz;
     size_t lineWidth = srcStride < dstStride ? srcStride : dstStride;
     for (size_t i = 0; i < height; ++i) {
         memcpy(dstPtr, srcPtr, lineWidth);
@@ -395,9 +815,10 @@ void snapshot_stagerender(
 void capture_region_from_stagerender(
     struct pm_filter_data* filter, gs_stagesurf_t* sss, gs_texrender_t* stx)
 {
+    const struct pm_filter_config* cfg = filter->frame_config;
     const uint32_t pixSz = 4;
-    uint32_t width = filter->select_right - filter->select_left + 1;
-    uint32_t height = filter->select_top - filter->select_bottom + 1;
+    uint32_t width = cfg->select_right - cfg->select_left + 1;
+    uint32_t height = cfg->select_top - cfg->select_bottom + 1;
     uint8_t* dst_ptr;
     uint32_t dst_stride = width * pixSz;
 
@@ -412,51 +833,90 @@ void capture_region_from_stagerender(
         dst_ptr, dst_stride);
 }
 
-void capture_mask_tex_from_stagerender(
-    struct pm_filter_data* filter, gs_stagesurf_t* sss, gs_texrender_t* stx,
-    bool reset)
+bool region_texrender_begin(
+    struct pm_filter_data* filter, gs_texrender_t** stx)
 {
-    uint32_t width = filter->select_right - filter->select_left + 1;
-    uint32_t height = filter->select_top - filter->select_bottom + 1;
-    uint8_t* dst_ptr;
-    uint32_t dst_stride;
-
-    // mask begin
-    if (reset) {
-        if (filter->mask_region_texture)
-            gs_texture_destroy(filter->mask_region_texture);
-        filter->mask_region_texture = NULL;
-        filter->mask_region_texture = gs_texture_create(
-            (uint32_t)width, (uint32_t)height, GS_RGBA,
-            1, NULL, GS_DYNAMIC);
-    }
-    if (!gs_texture_map(filter->mask_region_texture, &dst_ptr, &dst_stride)) {
-        blog(LOG_ERROR, "pm_filter_data: failed to map texture");
-        return;
+    const struct pm_filter_config* cfg = filter->frame_config;
+    uint32_t width = cfg->select_right - cfg->select_left + 1;
+    uint32_t height = cfg->select_top - cfg->select_bottom + 1;
+
+    if (!*stx) {
+        *stx = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
     }
 
-    copy_region_from_stagerender(filter, sss, stx, dst_ptr, dst_stride);
+    gs_texrender_reset(*stx);
+    if (!gs_texrender_begin(*stx, width, height)) {
+        blog(LOG_ERROR, "%s",
+            obs_module_text("pm_filter_data: texrender begin failed"));
+        return false;
+    }
+    return true;
+}
+
+void region_snapshot_texrender(
+    struct pm_filter_data* filter, gs_texrender_t** stx,
+    obs_source_t* target, obs_source_t* parent)
+{
+    const struct pm_filter_config* cfg = filter->frame_config;
+
+    // render only the selected region of the source; nothing else is needed
+    // for automask, and the result never leaves the GPU
+    if (!region_texrender_begin(filter, stx))
+        return;
+
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+    struct vec4 clear_color;
+    vec4_zero(&clear_color);
+    gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+    gs_ortho((float)cfg->select_left, (float)(cfg->select_right + 1),
+        (float)cfg->select_bottom, (float)(cfg->select_top + 1),
+        -100.0f, 100.0f);
+
+    uint32_t parent_flags = obs_source_get_output_flags(target);
+    bool custom_draw = (parent_flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
+    bool async = (parent_flags & OBS_SOURCE_ASYNC) != 0;
+    if (target == parent && !custom_draw && !async) {
+        obs_source_default_render(target);
+    } else {
+        obs_source_video_render(target);
+    }
 
-    gs_texture_unmap(filter->mask_region_texture);
+    gs_blend_state_pop();
+    gs_texrender_end(*stx);
 }
 
-void configure_mask(struct pm_filter_data* filter)
+gs_texture_t* current_mask_texture(struct pm_filter_data* filter)
 {
-    size_t sel_idx = filter->selected_match_index;
-    if (sel_idx >= filter->num_match_entries) return;
-    struct pm_match_entry_data* entry = filter->match_entries + sel_idx;
-    float match_ratio = entry->cfg.per_pixel_err_thresh / 100.f;
+    gs_texrender_t* stx = filter->mask_texrender[filter->mask_read_idx];
+    return stx ? gs_texrender_get_texture(stx) : NULL;
+}
 
-    float roi_left_u
-        = (float)(filter->select_left) / (float)(filter->base_width);
-    float roi_bottom_v
-        = (float)(filter->select_bottom) / (float)(filter->base_height);
-    float roi_right_u
-        = (float)(filter->select_right + 1) / (float)(filter->base_width);
-    float roi_top_v
-        = (float)(filter->select_top + 1) / (float)(filter->base_height);
+void configure_mask(
+    struct pm_filter_data* filter, gs_texture_t* mask_tex, bool region_local)
+{
+    const struct pm_filter_config* cfg = filter->frame_config;
+    size_t sel_idx = cfg->selected_match_index;
+    if (sel_idx >= cfg->num_match_entries) return;
+    const struct pm_match_entry_config* entry_cfg
+        = cfg->match_entries + sel_idx;
+    float match_ratio = entry_cfg->per_pixel_err_thresh / 100.f;
+
+    float roi_left_u = 0.f, roi_bottom_v = 0.f;
+    float roi_right_u = 1.f, roi_top_v = 1.f;
+    if (!region_local) {
+        roi_left_u
+            = (float)(cfg->select_left) / (float)(filter->base_width);
+        roi_bottom_v
+            = (float)(cfg->select_bottom) / (float)(filter->base_height);
+        roi_right_u
+            = (float)(cfg->select_right + 1) / (float)(filter->base_width);
+        roi_top_v
+            = (float)(cfg->select_top + 1) / (float)(filter->base_height);
+    }
 
-    bool visualize = (filter->filter_mode == PM_MASK_VISUALIZE);
+    bool visualize = (filter->frame_mode == PM_MASK_VISUALIZE);
 
     gs_effect_set_atomic_uint(filter->param_compare_counter, 0);
     gs_effect_set_atomic_uint(filter->param_match_counter, 0);
@@ -468,7 +928,7 @@ void configure_mask(struct pm_filter_data* filter)
     gs_effect_set_bool(filter->param_mask_alpha, true);
     gs_effect_set_bool(filter->param_store_match_alpha, !visualize);
     gs_effect_set_vec3(filter->param_mask_color, &vec3_dummy);
-    gs_effect_set_texture(filter->param_match_img, filter->mask_region_texture);
+    gs_effect_set_texture(filter->param_match_img, mask_tex);
     gs_effect_set_bool(filter->param_show_border, visualize);
     gs_effect_set_bool(filter->param_show_color_indicator, visualize);
     gs_effect_set_float(filter->param_border_px_width,
@@ -485,58 +945,117 @@ void render_mask_visualization(struct pm_filter_data* filter)
             "pm_filter_data: obs_source_process_filter_begin failed.");
         return;
     }
-    configure_mask(filter);
+    configure_mask(filter, current_mask_texture(filter), false);
     obs_source_process_filter_end(filter->context, filter->effect,
         filter->base_width, filter->base_height);
 }
 
-void mask_stagerender(
+void mask_begin_texrender(
     struct pm_filter_data* filter, obs_source_t* target, obs_source_t* parent)
 {
-    // grab a snapshot to use it as input to mask rendering
-    snapshot_stagerender(filter, target, parent);
-    gs_texture_t* snapshot_texture 
-        = gs_texrender_get_texture(filter->snapshot_texrender);
+    // the initial mask is simply the selected region, as is
+    filter->mask_read_idx = 0;
+    region_snapshot_texrender(
+        filter, &filter->mask_texrender[0], target, parent);
+}
 
-    // prepare and render mask stagerender
-    stagerender_begin(
-        filter, &filter->mask_stagesurface, &filter->mask_texrender);
+void mask_accumulate_texrender(
+    struct pm_filter_data* filter, obs_source_t* target, obs_source_t* parent)
+{
+    const struct pm_filter_config* cfg = filter->frame_config;
+    uint32_t width = cfg->select_right - cfg->select_left + 1;
+    uint32_t height = cfg->select_top - cfg->select_bottom + 1;
+    size_t write_idx = filter->mask_read_idx ^ 1;
+
+    // grab the region to use it as input to mask rendering
+    region_snapshot_texrender(
+        filter, &filter->region_texrender, target, parent);
+    gs_texture_t* region_tex
+        = gs_texrender_get_texture(filter->region_texrender);
+    gs_texture_t* mask_tex = current_mask_texture(filter);
+    if (!region_tex || !mask_tex)
+        return;
 
-    gs_viewport_push();
-    gs_projection_push();
-    gs_ortho(0.0f, (float)filter->base_width, 0.0f, (float)filter->base_height,
-        -100.0f, 100.0f);
-    gs_set_viewport(0, 0, (int)filter->base_width, (int)filter->base_height);
+    // the previous mask is read from one texrender and the updated mask is
+    // written into the other; roles are swapped after every pass
+    if (!region_texrender_begin(filter, &filter->mask_texrender[write_idx]))
+        return;
 
+    gs_ortho(0.0f, (float)width, 0.0f, (float)height, -100.0f, 100.0f);
     gs_blend_state_push();
     gs_blend_function(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA);
 
     struct vec4 clear_color;
     vec4_zero(&clear_color);
-    if (filter->filter_mode == PM_MASK_END) {
-        size_t selIdx = filter->selected_match_index;
-        if (selIdx < filter->num_match_entries) {
-            struct pm_match_entry_data* entry = filter->match_entries + selIdx;
-            if (!entry->cfg.mask_alpha) {
+    if (filter->frame_mode == PM_MASK_END) {
+        size_t selIdx = cfg->selected_match_index;
+        if (selIdx < cfg->num_match_entries) {
+            const struct pm_match_entry_config* entry_cfg
+                = cfg->match_entries + selIdx;
+            if (!entry_cfg->mask_alpha) {
                 // background color for the final mask capture, when appropriate
-                vec4_from_vec3(&clear_color, &entry->cfg.mask_color);
+                vec4_from_vec3(&clear_color, &entry_cfg->mask_color);
             }
         }
     }
     gs_clear(GS_CLEAR_COLOR, &clear_color, .0f, 0);
 
-    gs_effect_set_texture(filter->param_image, snapshot_texture);
-    configure_mask(filter);
+    gs_effect_set_texture(filter->param_image, region_tex);
+    configure_mask(filter, mask_tex, true);
     while (gs_effect_loop(filter->effect, "Draw")) {
-        gs_draw(GS_TRISTRIP, 0, 0);
+        gs_draw_sprite(region_tex, 0, width, height);
     }
 
     gs_blend_state_pop();
+    gs_texrender_end(filter->mask_texrender[write_idx]);
+
+    filter->mask_read_idx = write_idx;
+}
 
-    gs_projection_pop();
-    gs_viewport_pop();
+void capture_mask_from_texrender(struct pm_filter_data* filter)
+{
+    // the only readback of an automask session happens here
+    const struct pm_filter_config* cfg = filter->frame_config;
+    const size_t pixSz = 4;
+    uint32_t width = cfg->select_right - cfg->select_left + 1;
+    uint32_t height = cfg->select_top - cfg->select_bottom + 1;
+
+    gs_texture_t* tex = current_mask_texture(filter);
+    if (!tex)
+        return;
+
+    gs_stagesurf_t** sss = &filter->mask_stagesurface;
+    if (*sss && (gs_stagesurface_get_width(*sss) != width
+              || gs_stagesurface_get_height(*sss) != height)) {
+        gs_stagesurface_destroy(*sss);
+        *sss = NULL;
+    }
+    if (!*sss) {
+        *sss = gs_stagesurface_create(width, height, GS_RGBA);
+    }
 
-    stagerender_end(filter->mask_texrender);
+    gs_stage_texture(*sss, tex);
+    uint8_t* srcPtr;
+    uint32_t srcStride;
+    if (!gs_stagesurface_map(*sss, &srcPtr, &srcStride)) {
+        blog(LOG_ERROR, "pm_filter_data: failed to map stage surface");
+        return;
+    }
+
+    size_t dstStride = (size_t)width * pixSz;
+    if (filter->captured_region_data)
+        bfree(filter->captured_region_data);
+    filter->captured_region_data
+        = (uint8_t*)bmalloc(dstStride * (size_t)height);
+
+    uint8_t* dstPtr = filter->captured_region_data;
+    size_t lineWidth = srcStride < dstStride ? srcStride : dstStride;
+    for (size_t i = 0; i < height; ++i) {
+        memcpy(dstPtr, srcPtr, lineWidth);
+        dstPtr += dstStride;
+        srcPtr += srcStride;
+    }
+    gs_stagesurface_unmap(*sss);
 }
 
 static void pixel_match_filter_render(void *data, gs_effect_t *effect)
@@ -544,9 +1063,18 @@ static void pixel_match_filter_render(void *data, gs_effect_t *effect)
     struct pm_filter_data *filter = data;
     obs_source_t *target, *parent;
     enum pm_filter_mode prevMode;
-
-    pthread_mutex_lock(&filter->mutex);
-    prevMode = filter->filter_mode;
+    void (*on_match_image_captured)(struct pm_filter_data *);
+    void (*on_frame_processed)(struct pm_filter_data *);
+
+    // nothing here waits for other threads; configuration is read from the
+    // published snapshot and the filter mode is sampled once per frame
+    filter->frame_config = config_read_begin(filter);
+    filter->frame_mode
+        = (enum pm_filter_mode)os_atomic_load_long(&filter->filter_mode);
+    prevMode = filter->frame_mode;
+    on_match_image_captured = filter->frame_config->on_match_image_captured;
+    on_frame_processed = filter->frame_config->on_frame_processed;
+    sync_match_entries(filter);
 
     target = obs_filter_get_target(filter->context);
     parent = obs_filter_get_parent(filter->context);
@@ -557,71 +1085,76 @@ static void pixel_match_filter_render(void *data, gs_effect_t *effect)
         filter->base_width = 0;
         filter->base_height = 0;
     }
+    os_atomic_set_long(&filter->shared_base_width, (long)filter->base_width);
+    os_atomic_set_long(&filter->shared_base_height, (long)filter->base_height);
 
     if (filter->base_width == 0 || filter->base_height == 0)
         goto done;
 
-    if (filter->filter_mode == PM_SNAPSHOT) {
+    if (filter->frame_mode == PM_SNAPSHOT) {
         snapshot_stagerender(filter, target, parent);
         capture_region_from_stagerender(filter,
             filter->snapshot_stagesurface, filter->snapshot_texrender);
         goto done;
     }
 
-    if (filter->filter_mode == PM_MASK_BEGIN) {
-        snapshot_stagerender(filter, target, parent);
-        capture_mask_tex_from_stagerender(
-            filter, filter->snapshot_stagesurface, filter->snapshot_texrender,
-            true);
+    if (filter->frame_mode == PM_MASK_BEGIN) {
+        mask_begin_texrender(filter, target, parent);
         goto done;
     }
 
-    if (filter->filter_mode == PM_MASK) {
-        mask_stagerender(filter, target, parent);
-        capture_mask_tex_from_stagerender(
-            filter, filter->mask_stagesurface, filter->mask_texrender,
-            false);
+    if (filter->frame_mode == PM_MASK) {
+        mask_accumulate_texrender(filter, target, parent);
         render_passthrough(filter);
         goto done;
     }
 
-    if (filter->filter_mode == PM_MASK_END) {
-        mask_stagerender(filter, target, parent);
-        capture_region_from_stagerender(filter,
-            filter->mask_stagesurface, filter->mask_texrender);
+    if (filter->frame_mode == PM_MASK_END) {
+        mask_accumulate_texrender(filter, target, parent);
+        capture_mask_from_texrender(filter);
         goto done;
     }
 
-    if (filter->filter_mode == PM_MASK_VISUALIZE) {
+    if (filter->frame_mode == PM_MASK_VISUALIZE) {
         render_mask_visualization(filter);
         goto done;
     }
 
-    if (filter->filter_mode == PM_SELECT_REGION_VISUALIZE) {
+    if (filter->frame_mode == PM_SELECT_REGION_VISUALIZE) {
         render_select_region(filter);
         goto done;
     }
 
     render_match_entries(filter);
 
+    // new images are picked up whenever PmCore isn't queueing more of them
+    if (pthread_mutex_trylock(&filter->upload_mutex) == 0) {
+        take_pending_images(filter);
+        upload_match_textures(filter);
+        pthread_mutex_unlock(&filter->upload_mutex);
+    }
+
 done:
-    if (filter->filter_mode == PM_MATCH_VISUALIZE
-     || filter->filter_mode == PM_SELECT_REGION_VISUALIZE)
-        filter->filter_mode = PM_MATCH;
-    else if (filter->filter_mode == PM_MASK_VISUALIZE
-          || filter->filter_mode == PM_MASK_BEGIN)
-        filter->filter_mode = PM_MASK;
-    pthread_mutex_unlock(&filter->mutex);
-
-    if (filter->on_match_image_captured
+    // a mode set by another thread during the frame takes precedence
+    if (prevMode == PM_MATCH_VISUALIZE
+     || prevMode == PM_SELECT_REGION_VISUALIZE) {
+        os_atomic_compare_swap_long(
+            &filter->filter_mode, (long)prevMode, (long)PM_MATCH);
+    } else if (prevMode == PM_MASK_VISUALIZE || prevMode == PM_MASK_BEGIN) {
+        os_atomic_compare_swap_long(
+            &filter->filter_mode, (long)prevMode, (long)PM_MASK);
+    }
+    config_read_end(filter);
+
+    if (on_match_image_captured
      && (prevMode == PM_SNAPSHOT || prevMode == PM_MASK_END)) {
-        filter->on_match_image_captured(filter);
+        on_match_image_captured(filter);
     }
 
     if ((prevMode == PM_MASK 
       || (prevMode == PM_MATCH && filter->num_match_entries > 0))
-     && filter->on_frame_processed) {
-        filter->on_frame_processed(filter);
+     && on_frame_processed) {
+        on_frame_processed(filter);
     }
 
     UNUSED_PARAMETER(effect);
@@ -662,6 +1195,9 @@ static obs_properties_t* pixel_match_filter_properties(void* data)
     obs_properties_add_button(props, "settings_button",
         obs_module_text("Open Settings"), settings_button_callback);
 
+    obs_properties_add_int(props, "texture_cache_mb",
+        obs_module_text("Match Texture Cache, MB"), 0, 4096, 16);
+
 #if 0
     obs_properties_add_int(properties,
         "roi_left", obs_module_text("Roi Left"),
@@ -707,9 +1243,9 @@ struct obs_source_info pixel_match_filter = {
     .get_name = pixel_match_filter_get_name,
     .create = pixel_match_filter_create,
     .destroy = pixel_match_filter_destroy,
-    //.update = pixel_match_filter_update,
+    .update = pixel_match_filter_update,
     .get_properties = pixel_match_filter_properties,
-    //.get_defaults = pixel_match_filter_defaults,
+    .get_defaults = pixel_match_filter_defaults,
     //.video_tick = pixel_match_filter_tick,
     .video_render = pixel_match_filter_render,
     .get_width = pixel_match_filter_width,
@@ -718,68 +1254,305 @@ struct obs_source_info pixel_match_filter = {
 
 //---------------------------------------
 
-void pm_destroy_match_gfx(struct gs_texture *tex, void *img_data)
+void pm_supply_match_entry_config(struct pm_filter_data *filter,
+    size_t match_idx, const struct pm_match_entry_config *cfg)
 {
-    if (tex) {
-        obs_enter_graphics();
-        gs_texture_destroy(tex);
-        obs_leave_graphics();
+    struct pm_filter_config *fc = config_write_begin(filter);
+    if (match_idx < fc->num_match_entries) {
+        memcpy(fc->match_entries + match_idx, cfg,
+               sizeof(struct pm_match_entry_config));
     }
-    if (img_data) {
-        bfree(img_data);
+    config_write_end(filter);
+}
+
+static struct pm_entry_handle alloc_entry_handle(
+    struct pm_filter_data *filter)
+{
+    struct pm_entry_handle handle;
+    if (filter->num_free_slots > 0) {
+        handle.slot = filter->free_slots[--filter->num_free_slots];
+    } else {
+        if (filter->num_slots == filter->slots_capacity) {
+            size_t new_capacity = filter->slots_capacity
+                ? filter->slots_capacity * 2 : 16;
+            filter->slot_generations = (uint32_t *)brealloc(
+                filter->slot_generations, sizeof(uint32_t) * new_capacity);
+            filter->free_slots = (uint32_t *)brealloc(
+                filter->free_slots, sizeof(uint32_t) * new_capacity);
+            filter->slots_capacity = new_capacity;
+        }
+        handle.slot = (uint32_t)filter->num_slots++;
+        filter->slot_generations[handle.slot] = 1;
     }
+    handle.generation = filter->slot_generations[handle.slot];
+    return handle;
 }
 
-void pm_supply_match_entry_config(struct pm_filter_data *filter,
-    size_t match_idx, const struct pm_match_entry_config *cfg)
+static void free_entry_handle(
+    struct pm_filter_data *filter, struct pm_entry_handle handle)
 {
-    pthread_mutex_lock(&filter->mutex);
-    if (match_idx >= filter->num_match_entries) {
-        pthread_mutex_unlock(&filter->mutex);
+    // generation 0 is left to pool slots the render thread hasn't used yet
+    if (++filter->slot_generations[handle.slot] == 0)
+        filter->slot_generations[handle.slot] = 1;
+    filter->free_slots[filter->num_free_slots++] = handle.slot;
+}
+
+static void resize_config_entries(struct pm_filter_data *filter,
+    struct pm_filter_config *fc, size_t new_size)
+{
+    if (new_size == fc->num_match_entries)
         return;
+
+    reserve_config_entries(fc, new_size);
+    for (size_t i = new_size; i < fc->num_match_entries; ++i) {
+        free_entry_handle(filter, fc->match_handles[i]);
     }
+    for (size_t i = fc->num_match_entries; i < new_size; ++i) {
+        memset((void *)(fc->match_entries + i), 0,
+               sizeof(struct pm_match_entry_config));
+        fc->match_handles[i] = alloc_entry_handle(filter);
+    }
+    fc->num_match_entries = new_size;
+    fc->entries_version++;
+}
 
-    struct pm_match_entry_data *entry = filter->match_entries + match_idx;
-    memcpy(&entry->cfg, cfg, sizeof(struct pm_match_entry_config));
-    pthread_mutex_unlock(&filter->mutex);
+static void prune_pending_images(struct pm_filter_data *filter)
+{
+    // drop queued images of entries that no longer exist; called by writers,
+    // which own the slot generations
+    pthread_mutex_lock(&filter->upload_mutex);
+    size_t kept = 0;
+    for (size_t i = 0; i < filter->num_pending_images; ++i) {
+        struct pm_pending_image *pending = filter->pending_images + i;
+        struct pm_entry_handle handle = pending->handle;
+        if (filter->slot_generations[handle.slot] == handle.generation) {
+            filter->pending_images[kept++] = *pending;
+        } else if (pending->pinned_tex) {
+            // only the render thread touches reference counts; it drops
+            // the image and its pin
+            free_image_data(&pending->data);
+            pending->dropped = true;
+            filter->pending_images[kept++] = *pending;
+        } else {
+            free_image_data(&pending->data);
+        }
+    }
+    filter->num_pending_images = kept;
+    pthread_mutex_unlock(&filter->upload_mutex);
 }
 
 void pm_resize_match_entries(struct pm_filter_data *filter, size_t new_size)
 {
-    pthread_mutex_lock(&filter->mutex);
-    if (new_size == filter->num_match_entries) {
-        pthread_mutex_unlock(&filter->mutex);
-        return;
+    struct pm_filter_config *fc = config_write_begin(filter);
+    resize_config_entries(filter, fc, new_size);
+    prune_pending_images(filter);
+    config_write_end(filter);
+}
+
+void pm_set_match_entry_configs(struct pm_filter_data *filter,
+    size_t num_entries, const struct pm_match_entry_config *cfgs)
+{
+    // whole configuration is replaced with a single publish
+    struct pm_filter_config *fc = config_write_begin(filter);
+    resize_config_entries(filter, fc, num_entries);
+    if (num_entries) {
+        memcpy(fc->match_entries, cfgs,
+               sizeof(struct pm_match_entry_config) * num_entries);
     }
+    prune_pending_images(filter);
+    config_write_end(filter);
+}
 
-    size_t old_size = filter->num_match_entries;
-    struct pm_match_entry_data *old_entries = filter->match_entries;
-    if (new_size > 0) {
-        filter->match_entries = (struct pm_match_entry_data *)bmalloc(
-            sizeof(struct pm_match_entry_data) * new_size);
-        for (size_t i = 0; i < new_size; ++i) {
-            if (i < old_size) {
-                memcpy((void *)(filter->match_entries + i),
-                       (void *)(old_entries + i),
-                       sizeof(struct pm_match_entry_data));
-            } else {
-                memset((void *)(filter->match_entries + i), 0,
-                       sizeof(struct pm_match_entry_data));
-            }
-        }
-    } else {
-        filter->match_entries = NULL;
+void pm_insert_match_entry(struct pm_filter_data *filter,
+    size_t match_idx, const struct pm_match_entry_config *cfg)
+{
+    struct pm_filter_config *fc = config_write_begin(filter);
+    size_t sz = fc->num_match_entries;
+    if (match_idx > sz)
+        match_idx = sz;
+
+    // entries after the new one keep their handles, and with them their
+    // render state and textures
+    reserve_config_entries(fc, sz + 1);
+    memmove(fc->match_entries + match_idx + 1, fc->match_entries + match_idx,
+            sizeof(struct pm_match_entry_config) * (sz - match_idx));
+    memmove(fc->match_handles + match_idx + 1, fc->match_handles + match_idx,
+            sizeof(struct pm_entry_handle) * (sz - match_idx));
+    fc->match_entries[match_idx] = *cfg;
+    fc->match_handles[match_idx] = alloc_entry_handle(filter);
+    fc->num_match_entries = sz + 1;
+    fc->entries_version++;
+    config_write_end(filter);
+}
+
+void pm_remove_match_entry(struct pm_filter_data *filter, size_t match_idx)
+{
+    struct pm_filter_config *fc = config_write_begin(filter);
+    size_t sz = fc->num_match_entries;
+    if (match_idx < sz) {
+        free_entry_handle(filter, fc->match_handles[match_idx]);
+        memmove(fc->match_entries + match_idx,
+                fc->match_entries + match_idx + 1,
+                sizeof(struct pm_match_entry_config) * (sz - match_idx - 1));
+        memmove(fc->match_handles + match_idx,
+                fc->match_handles + match_idx + 1,
+                sizeof(struct pm_entry_handle) * (sz - match_idx - 1));
+        fc->num_match_entries = sz - 1;
+        fc->entries_version++;
+        prune_pending_images(filter);
     }
-    filter->num_match_entries = new_size;
-    pthread_mutex_unlock(&filter->mutex);
+    config_write_end(filter);
+}
 
-    for (size_t i = new_size; i < old_size; i++) {
-        struct pm_match_entry_data *old_entry = old_entries + i;
-        pm_destroy_match_gfx(old_entry->match_img_tex,
-                     old_entry->match_img_data);
+void pm_swap_match_entries(
+    struct pm_filter_data *filter, size_t idx_a, size_t idx_b)
+{
+    struct pm_filter_config *fc = config_write_begin(filter);
+    if (idx_a < fc->num_match_entries && idx_b < fc->num_match_entries
+     && idx_a != idx_b) {
+        struct pm_match_entry_config cfg = fc->match_entries[idx_a];
+        fc->match_entries[idx_a] = fc->match_entries[idx_b];
+        fc->match_entries[idx_b] = cfg;
+
+        struct pm_entry_handle handle = fc->match_handles[idx_a];
+        fc->match_handles[idx_a] = fc->match_handles[idx_b];
+        fc->match_handles[idx_b] = handle;
+        fc->entries_version++;
     }
-    if (old_entries)
-        bfree(old_entries);
+    config_write_end(filter);
+}
+
+void pm_supply_match_image(struct pm_filter_data *filter,
+    size_t match_idx, uint64_t hash, uint32_t width, uint32_t height,
+    int offset_left, int offset_bottom, const void *data, size_t data_size,
+    void (*release)(void *opaque), void *opaque)
+{
+    // lent pixels are used in place and given back once uploaded or
+    // no longer needed; others are copied
+    struct pm_image_data image_data = {(void *)data, release, opaque};
+    if (!data_size) {
+        free_image_data(&image_data);
+    } else if (!release) {
+        image_data.pixels = bmalloc(data_size);
+        memcpy(image_data.pixels, data, data_size);
+    }
+
+    // the image follows its entry, wherever the entry is moved later on;
+    // writers are held off until it's queued, so the handle stays valid
+    pthread_mutex_lock(&filter->config_mutex);
+    const struct pm_filter_config *fc = filter->configs
+        + os_atomic_load_long(&filter->config_published);
+    if (match_idx >= fc->num_match_entries) {
+        pthread_mutex_unlock(&filter->config_mutex);
+        free_image_data(&image_data);
+        return;
+    }
+    struct pm_entry_handle handle = fc->match_handles[match_idx];
+
+    pthread_mutex_lock(&filter->upload_mutex);
+
+    // replace an image for the same entry that the filter didn't get to yet;
+    // one that holds a pin is left for the render thread to drop
+    struct pm_pending_image *pending = NULL;
+    for (size_t i = 0; i < filter->num_pending_images; ++i) {
+        struct pm_pending_image *other = filter->pending_images + i;
+        if (other->handle.slot == handle.slot
+         && other->handle.generation == handle.generation
+         && !other->dropped) {
+            free_image_data(&other->data);
+            if (other->pinned_tex)
+                other->dropped = true;
+            else
+                pending = other;
+            break;
+        }
+    }
+    if (!pending) {
+        if (filter->num_pending_images == filter->pending_images_capacity) {
+            size_t new_capacity = filter->pending_images_capacity
+                ? filter->pending_images_capacity * 2 : 16;
+            filter->pending_images = (struct pm_pending_image *)brealloc(
+                filter->pending_images,
+                sizeof(struct pm_pending_image) * new_capacity);
+            filter->pending_images_capacity = new_capacity;
+        }
+        pending = filter->pending_images + filter->num_pending_images++;
+        pending->pinned_tex = NULL;
+        pending->dropped = false;
+    }
+
+    pending->handle = handle;
+    pending->hash = hash;
+    pending->width = width;
+    pending->height = height;
+    pending->offset_left = offset_left;
+    pending->offset_bottom = offset_bottom;
+
+    // the cache layout only changes on the render thread under this mutex,
+    // and a hit gets pinned there before anything can be evicted
+    pending->use_cache = data_size
+        ? find_cached_texture(filter, hash, width, height) != NULL : false;
+    if (pending->use_cache)
+        free_image_data(&image_data);
+    pending->data = image_data;
+    pthread_mutex_unlock(&filter->upload_mutex);
+    pthread_mutex_unlock(&filter->config_mutex);
+}
+
+void pm_select_match_entry(struct pm_filter_data *filter, size_t match_idx)
+{
+    struct pm_filter_config *fc = config_write_begin(filter);
+    fc->selected_match_index = match_idx;
+    config_write_end(filter);
+}
+
+void pm_set_select_region(struct pm_filter_data *filter,
+    uint32_t left, uint32_t bottom, uint32_t right, uint32_t top)
+{
+    struct pm_filter_config *fc = config_write_begin(filter);
+    fc->select_left = left;
+    fc->select_bottom = bottom;
+    fc->select_right = right;
+    fc->select_top = top;
+    config_write_end(filter);
+}
+
+void pm_set_filter_callbacks(struct pm_filter_data *filter,
+    void (*on_frame_processed)(struct pm_filter_data *),
+    void (*on_match_image_captured)(struct pm_filter_data *))
+{
+    struct pm_filter_config *fc = config_write_begin(filter);
+    fc->on_frame_processed = on_frame_processed;
+    fc->on_match_image_captured = on_match_image_captured;
+    config_write_end(filter);
+}
+
+enum pm_filter_mode pm_get_filter_mode(struct pm_filter_data *filter)
+{
+    return (enum pm_filter_mode)os_atomic_load_long(&filter->filter_mode);
+}
+
+void pm_set_filter_mode(
+    struct pm_filter_data *filter, enum pm_filter_mode mode)
+{
+    os_atomic_set_long(&filter->filter_mode, (long)mode);
+}
+
+bool pm_replace_filter_mode(struct pm_filter_data *filter,
+    enum pm_filter_mode expected, enum pm_filter_mode mode)
+{
+    return os_atomic_compare_swap_long(
+        &filter->filter_mode, (long)expected, (long)mode);
+}
+
+uint32_t pm_get_base_width(struct pm_filter_data *filter)
+{
+    return (uint32_t)os_atomic_load_long(&filter->shared_base_width);
+}
+
+uint32_t pm_get_base_height(struct pm_filter_data *filter)
+{
+    return (uint32_t)os_atomic_load_long(&filter->shared_base_height);
 }
 
 
@@ -834,26 +1607,6 @@ void pm_resize_match_entries(struct pm_filter_data *filter, size_t new_size)
     }
 #endif
 
-#if 0
-    static void pixel_match_filter_update(void* data, obs_data_t* settings)
-    {
-        struct pm_filter_data* filter = data;
-
-        pthread_mutex_lock(&filter->mutex);
-        filter->roi_left = (int)obs_data_get_int(settings, "roi_left");
-        filter->roi_bottom = (int)obs_data_get_int(settings, "roi_bottom");
-        filter->per_pixel_err_thresh
-            = (int)obs_data_get_int(settings, "per_pixel_err_thresh");
-        filter->total_match_thresh
-            = (int)obs_data_get_int(settings, "total_match_thresh");
-        // TODO mask image
-        // TODO scenes
-        pthread_mutex_unlock(&filter->mutex);
-
-        UNUSED_PARAMETER(data);
-    }
-#endif
-
 #if 0
     static bool pixel_match_prop_changed_callback(
         obs_properties_t* props, obs_property_t* p, obs_data_t* settings)
@@ -874,11 +1627,3 @@ void pm_resize_match_entries(struct pm_filter_data *filter, size_t new_size)
         // TODO: dispatch pixel processing every
     }
 #endif
-
-#if 0
-static void pixel_match_filter_defaults(obs_data_t *settings)
-{
-    obs_data_set_default_int(settings, "per_pixel_err_thresh", 10);
-    obs_data_set_default_int(settings, "total_match_thresh", 90);
-}
-#endif
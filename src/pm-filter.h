@@ -18,20 +18,112 @@ struct pm_match_entry_config
     struct vec3 mask_color;
 };
 
+/**
+ * @brief Identifies a match entry regardless of its position in the list.
+ *        A slot is reused after its entry is removed, but with a new
+ *        generation, so a stale handle never refers to the newcomer.
+ */
+struct pm_entry_handle
+{
+    uint32_t slot;
+    uint32_t generation;
+};
+
+/**
+ * @brief Pixels of a match image. Pixels lent by the caller are given back
+ *        through release(opaque); without release, they were bmalloc'ed.
+ */
+struct pm_image_data
+{
+    void* pixels;
+    void (*release)(void* opaque);
+    void* opaque;
+};
+
+/**
+ * @brief Render thread state of a match entry. Configuration of the entry
+ *        lives in pm_filter_config.
+ */
 struct pm_match_entry_data
 {
-    struct pm_match_entry_config cfg;
+    // generation of the handle the pool slot currently belongs to
+    uint32_t generation;
+    bool in_config;
 
-    // match image data
-    void* match_img_data;
+    // match image data; pixels wait in match_img_data until the filter
+    // uploads them, and the entry isn't ready for matching until then
+    struct pm_image_data match_img_data;
+    uint64_t match_img_hash;
     uint32_t match_img_width, match_img_height;
+
+    // image is cropped to its active pixels; offset is added to the ROI
+    int match_img_offset_left, match_img_offset_bottom;
+
+    // texture is borrowed from the filter's texture cache
     gs_texture_t* match_img_tex;
+    bool is_ready;
 
     // results
     uint32_t num_compared;
     uint32_t num_matched;
 };
 
+/**
+ * @brief A match texture shared by all entries with identical image content.
+ *        Unreferenced textures are kept around until evicted by LRU order.
+ */
+struct pm_texture_cache_entry
+{
+    uint64_t hash;
+    uint32_t width, height;
+    gs_texture_t* tex;
+    size_t ref_count;
+    uint64_t last_used;
+};
+
+/**
+ * @brief Match image handed over to the render thread for upload. Without
+ *        data, the image is either already cached (use_cache) or cleared.
+ *        The render thread pins a cached texture (pinned_tex) until the image
+ *        is taken; writers mark such images dropped instead of removing them.
+ */
+struct pm_pending_image
+{
+    struct pm_entry_handle handle;
+    uint64_t hash;
+    uint32_t width, height;
+    int offset_left, offset_bottom;
+    struct pm_image_data data;
+    bool use_cache;
+    bool dropped;
+    gs_texture_t* pinned_tex;
+};
+
+struct pm_filter_data;
+
+/**
+ * @brief Configuration written by PmCore and read by the render thread.
+ *        The filter keeps two copies: the render thread reads the published
+ *        one without locking while a writer fills in the other, then
+ *        publishes it with an atomic swap of the index.
+ */
+struct pm_filter_config
+{
+    size_t num_match_entries;
+    size_t match_entries_capacity;
+    struct pm_match_entry_config* match_entries;
+    struct pm_entry_handle* match_handles;
+    uint64_t entries_version; // changes whenever handles are rearranged
+    size_t selected_match_index;
+
+    // selection mode and snapshot
+    uint32_t select_left, select_bottom, select_right, select_top;
+
+    // callbacks for fast reactions
+    void (*on_match_image_captured)(struct pm_filter_data *data);
+    void (*on_frame_processed)(struct pm_filter_data* filter_data);
+};
+
 enum pm_filter_mode { 
     PM_MATCH = 0, PM_MATCH_VISUALIZE = 1, 
     PM_MASK_BEGIN = 2, PM_MASK = 3, PM_MASK_END = 4, PM_MASK_VISUALIZE = 5, 
@@ -66,38 +158,68 @@ struct pm_filter_data
     gs_eresult_t *result_compare_counter;
     gs_eresult_t *result_match_counter;
 
-    // match data
-    size_t num_match_entries;
-    struct pm_match_entry_data* match_entries;
+    // published configuration; config_reading is the index of the copy the
+    // render thread is reading, or -1. writers wait for the render thread to
+    // let go of a copy before reusing it, so a snapshot is never modified
+    // while it is in use
+    struct pm_filter_config configs[2];
+    volatile long config_published;
+    volatile long config_reading;
+    pthread_mutex_t config_mutex; // serializes writers; never taken in render
 
-    // dynamic data
-    pthread_mutex_t mutex;
-    size_t selected_match_index;
+    // entry slots handed out by writers, under config_mutex
+    uint32_t* slot_generations;
+    uint32_t* free_slots;
+    size_t num_slots, slots_capacity, num_free_slots;
+
+    // images waiting for upload; the render thread only try-locks this mutex,
+    // which also protects the texture cache layout and budget
+    pthread_mutex_t upload_mutex;
+    struct pm_pending_image* pending_images;
+    size_t num_pending_images, pending_images_capacity;
+
+    // match data; owned by the render thread. entries stay put in a pool
+    // indexed by slot; match_entries lists them in configuration order
+    struct pm_match_entry_data* entry_pool;
+    size_t entry_pool_size;
+    struct pm_match_entry_data** match_entries;
+    size_t num_match_entries, match_entries_capacity;
+    uint64_t synced_entries_version;
+
+    // match textures by image content; survives preset switches
+    struct pm_texture_cache_entry* tex_cache;
+    size_t tex_cache_size, tex_cache_capacity;
+    size_t tex_cache_bytes;
+    size_t tex_cache_budget;
+    uint64_t tex_cache_clock;
+
+    // state shared between threads, accessed atomically
+    volatile long filter_mode;
+    volatile long shared_base_width, shared_base_height;
+
+    // render thread state
+    const struct pm_filter_config* frame_config;
+    enum pm_filter_mode frame_mode;
     uint32_t base_width;
     uint32_t base_height;
-    enum pm_filter_mode filter_mode;
 
-    // selection mode and snapshot
-    uint32_t select_left, select_bottom, select_right, select_top;
+    // snapshot
     uint8_t* captured_region_data;
 
     gs_texrender_t* snapshot_texrender;
     gs_stagesurf_t* snapshot_stagesurface;
     
-    gs_texrender_t* mask_texrender;
+    // automask: region-sized ping-pong targets stay on the GPU; the stage
+    // surface is only used once, for the final readback
+    gs_texrender_t* region_texrender;
+    gs_texrender_t* mask_texrender[2];
+    size_t mask_read_idx;
     gs_stagesurf_t* mask_stagesurface;
-    gs_texture_t* mask_region_texture;
-
-    // callbacks for fast reactions
-    void (*on_match_image_captured)(struct pm_filter_data *data);
-    void (*on_frame_processed)(struct pm_filter_data* filter_data);
 
     // callback for showing dialog upon settings button in filter UI
     void (*on_settings_button_released)();
 };
 
-void pm_destroy_match_gfx(struct gs_texture *tex, void *img_data);
-
 #ifdef __cplusplus
 }
 #endif
@@ -108,9 +230,87 @@ extern "C" void pm_supply_match_entry_config(struct pm_filter_data *filter,
 
 extern "C" void pm_resize_match_entries(
                 struct pm_filter_data *filter, size_t new_size);
+
+extern "C" void pm_set_match_entry_configs(struct pm_filter_data *filter,
+                size_t num_entries, const struct pm_match_entry_config *cfgs);
+
+extern "C" void pm_insert_match_entry(struct pm_filter_data *filter,
+                size_t match_idx, const struct pm_match_entry_config *cfg);
+
+extern "C" void pm_remove_match_entry(
+                struct pm_filter_data *filter, size_t match_idx);
+
+extern "C" void pm_swap_match_entries(
+                struct pm_filter_data *filter, size_t idx_a, size_t idx_b);
+
+extern "C" void pm_supply_match_image(struct pm_filter_data *filter,
+                size_t match_idx, uint64_t hash, uint32_t width,
+                uint32_t height, int offset_left, int offset_bottom,
+                const void *data, size_t data_size,
+                void (*release)(void *opaque), void *opaque);
+
+extern "C" void pm_select_match_entry(
+                struct pm_filter_data *filter, size_t match_idx);
+
+extern "C" void pm_set_select_region(struct pm_filter_data *filter,
+                uint32_t left, uint32_t bottom, uint32_t right, uint32_t top);
+
+extern "C" void pm_set_filter_callbacks(struct pm_filter_data *filter,
+                void (*on_frame_processed)(struct pm_filter_data *),
+                void (*on_match_image_captured)(struct pm_filter_data *));
+
+extern "C" enum pm_filter_mode pm_get_filter_mode(
+                struct pm_filter_data *filter);
+
+extern "C" void pm_set_filter_mode(
+                struct pm_filter_data *filter, enum pm_filter_mode mode);
+
+extern "C" bool pm_replace_filter_mode(struct pm_filter_data *filter,
+                enum pm_filter_mode expected, enum pm_filter_mode mode);
+
+extern "C" uint32_t pm_get_base_width(struct pm_filter_data *filter);
+
+extern "C" uint32_t pm_get_base_height(struct pm_filter_data *filter);
 #else
 void pm_supply_match_entry_config(struct pm_filter_data *filter,
      size_t match_idx, const struct pm_match_entry_config *cfg);
 
 void pm_resize_match_entries(struct pm_filter_data *filter, size_t new_size);
+
+void pm_set_match_entry_configs(struct pm_filter_data *filter,
+     size_t num_entries, const struct pm_match_entry_config *cfgs);
+
+void pm_insert_match_entry(struct pm_filter_data *filter,
+     size_t match_idx, const struct pm_match_entry_config *cfg);
+
+void pm_remove_match_entry(struct pm_filter_data *filter, size_t match_idx);
+
+void pm_swap_match_entries(
+     struct pm_filter_data *filter, size_t idx_a, size_t idx_b);
+
+void pm_supply_match_image(struct pm_filter_data *filter,
+     size_t match_idx, uint64_t hash, uint32_t width, uint32_t height,
+     int offset_left, int offset_bottom, const void *data, size_t data_size,
+     void (*release)(void *opaque), void *opaque);
+
+void pm_select_match_entry(struct pm_filter_data *filter, size_t match_idx);
+
+void pm_set_select_region(struct pm_filter_data *filter,
+     uint32_t left, uint32_t bottom, uint32_t right, uint32_t top);
+
+void pm_set_filter_callbacks(struct pm_filter_data *filter,
+     void (*on_frame_processed)(struct pm_filter_data *),
+     void (*on_match_image_captured)(struct pm_filter_data *));
+
+enum pm_filter_mode pm_get_filter_mode(struct pm_filter_data *filter);
+
+void pm_set_filter_mode(
+     struct pm_filter_data *filter, enum pm_filter_mode mode);
+
+bool pm_replace_filter_mode(struct pm_filter_data *filter,
+     enum pm_filter_mode expected, enum pm_filter_mode mode);
+
+uint32_t pm_get_base_width(struct pm_filter_data *filter);
+
+uint32_t pm_get_base_height(struct pm_filter_data *filter);
 #endif
@@ -0,0 +1,184 @@
+#include "pm-image-cache.hpp"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+
+#include <cstring>
+
+#include <obs-module.h>
+#include <util/platform.h>
+
+// layout of an entry file; pixels follow right after, rows tightly packed
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int64_t sourceSize;
+    int64_t sourceModifiedMs;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytesPerLine;
+    uint32_t reserved;
+    uint64_t hash;
+    int32_t alphaLeft, alphaTop, alphaWidth, alphaHeight;
+};
+static_assert(sizeof(CacheHeader) % 16 == 0,
+              "pixels that follow the header must stay aligned");
+
+static const uint32_t k_cacheMagic = 0x49434d50; // "PMCI"
+static const uint32_t k_cacheVersion = 1;
+
+static void unmap_entry(void *info)
+{
+    // destroying the file unmaps its memory
+    delete static_cast<QFile*>(info);
+}
+
+PmImageCache::PmImageCache()
+{
+    char *path = os_get_config_path_ptr(
+        "obs-studio/plugin_config/PixelMatchSwitcher/image-cache/");
+    os_mkdirs(path);
+    m_cacheDir = QString::fromUtf8(path);
+    bfree(path);
+
+    // nothing is mapped yet; of the entries for each source, only the one
+    // written last can still be current (entries named after the path alone
+    // are from an older layout)
+    QDir dir(m_cacheDir);
+    QFileInfoList entries = dir.entryInfoList(
+        {"*.pmimg"}, QDir::Files, QDir::Time);
+    QSet<QString> seen;
+    for (const QFileInfo &entry : entries) {
+        QString prefix = entry.fileName().section('-', 0, 0);
+        if (!entry.fileName().contains('-') || seen.contains(prefix))
+            QFile::remove(entry.filePath());
+        else
+            seen.insert(prefix);
+    }
+}
+
+QString PmImageCache::entryPrefix(const QFileInfo &source) const
+{
+    quint64 pathHash = qHash(source.absoluteFilePath());
+    return QString("%1").arg(pathHash, 16, 16, QChar('0'));
+}
+
+QString PmImageCache::entryPath(const QFileInfo &source) const
+{
+    // each version of a source gets its own entry, so that a new one never
+    // has to replace a file that is still mapped (which Windows refuses)
+    return m_cacheDir + QString("%1-%2-%3.pmimg")
+        .arg(entryPrefix(source))
+        .arg(source.size())
+        .arg(source.lastModified().toMSecsSinceEpoch());
+}
+
+void PmImageCache::removeSuperseded(
+    const QFileInfo &source, const QString &currentPath) const
+{
+    // entries that are still mapped can't be removed on Windows; they are
+    // retried on the next store, or when the cache is opened again
+    QDir dir(m_cacheDir);
+    QStringList entries = dir.entryList(
+        {entryPrefix(source) + "-*.pmimg"}, QDir::Files);
+    for (const QString &entry : entries) {
+        QString entryPath = dir.filePath(entry);
+        if (entryPath != currentPath)
+            QFile::remove(entryPath);
+    }
+}
+
+PmDecodedImage PmImageCache::load(const QFileInfo &source) const
+{
+    PmDecodedImage ret;
+    int64_t sourceSize = source.size();
+    int64_t sourceModifiedMs = source.lastModified().toMSecsSinceEpoch();
+    if (!source.exists())
+        return ret;
+
+    QFile *file = new QFile(entryPath(source));
+    if (!file->open(QIODevice::ReadOnly)
+     || file->size() < qint64(sizeof(CacheHeader))) {
+        delete file;
+        return ret;
+    }
+
+    const uchar *mapped = file->map(0, file->size());
+    file->close();
+    if (!mapped) {
+        delete file;
+        return ret;
+    }
+
+    CacheHeader header;
+    memcpy(&header, mapped, sizeof(header));
+    bool valid = header.magic == k_cacheMagic
+        && header.version == k_cacheVersion
+        && header.sourceSize == sourceSize
+        && header.sourceModifiedMs == sourceModifiedMs
+        && header.bytesPerLine == header.width * 4
+        && file->size() == qint64(sizeof(CacheHeader))
+            + qint64(header.bytesPerLine) * qint64(header.height);
+    if (!valid) {
+        // stale or foreign entry; the caller decodes and replaces it
+        delete file;
+        return ret;
+    }
+
+    ret.image = QImage(mapped + sizeof(CacheHeader),
+        int(header.width), int(header.height), int(header.bytesPerLine),
+        QImage::Format_ARGB32, unmap_entry, file);
+    ret.hash = header.hash;
+    ret.alphaRegion = QRect(header.alphaLeft, header.alphaTop,
+                            header.alphaWidth, header.alphaHeight);
+    return ret;
+}
+
+void PmImageCache::store(
+    const QFileInfo &source, const PmDecodedImage &decoded) const
+{
+    const QImage &img = decoded.image;
+    if (img.isNull() || img.format() != QImage::Format_ARGB32)
+        return;
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = k_cacheMagic;
+    header.version = k_cacheVersion;
+    header.sourceSize = source.size();
+    header.sourceModifiedMs = source.lastModified().toMSecsSinceEpoch();
+    header.width = uint32_t(img.width());
+    header.height = uint32_t(img.height());
+    header.bytesPerLine = uint32_t(img.width()) * 4;
+    header.hash = decoded.hash;
+    header.alphaLeft = decoded.alphaRegion.left();
+    header.alphaTop = decoded.alphaRegion.top();
+    header.alphaWidth = decoded.alphaRegion.width();
+    header.alphaHeight = decoded.alphaRegion.height();
+
+    // written aside and renamed into place, so readers never see half
+    QString path = entryPath(source);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        blog(LOG_DEBUG, "Unable to write image cache entry %s: %s",
+             file.fileName().toUtf8().data(),
+             file.errorString().toUtf8().data());
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int y = 0; y < img.height(); ++y) {
+        file.write(reinterpret_cast<const char*>(img.constScanLine(y)),
+                   qint64(header.bytesPerLine));
+    }
+    if (!file.commit()) {
+        blog(LOG_WARNING, "Unable to write image cache entry %s: %s",
+             file.fileName().toUtf8().data(),
+             file.errorString().toUtf8().data());
+        return;
+    }
+    removeSuperseded(source, path);
+}
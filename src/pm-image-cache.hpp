@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QFileInfo>
+#include <QImage>
+#include <QRect>
+#include <QString>
+
+/**
+ * @brief A decoded match image, with the metadata that would otherwise be
+ *        recomputed from its pixels
+ */
+struct PmDecodedImage
+{
+    QImage image;
+    uint64_t hash = 0;
+    QRect alphaRegion; // bounds of pixels with non-zero alpha
+};
+
+/**
+ * @brief Keeps decoded match images on disk in Format_ARGB32, next to their
+ *        pixel hash and alpha bounds, so later loads memory-map the pixels
+ *        instead of decoding the source file. Entries are named after the
+ *        source's path, size and modification time, so a changed source gets
+ *        a new entry while the old one may still be mapped; superseded
+ *        entries are removed once they can be. Safe to use from any thread.
+ */
+class PmImageCache
+{
+public:
+    PmImageCache();
+
+    // source is stat'ed before decoding, so that an entry never claims a
+    // newer modification time than its pixels; null image on a miss
+    PmDecodedImage load(const QFileInfo &source) const;
+    void store(const QFileInfo &source, const PmDecodedImage &decoded) const;
+
+protected:
+    QString entryPrefix(const QFileInfo &source) const;
+    QString entryPath(const QFileInfo &source) const;
+    void removeSuperseded(
+        const QFileInfo &source, const QString &currentPath) const;
+
+    QString m_cacheDir;
+};
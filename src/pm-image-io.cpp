@@ -0,0 +1,91 @@
+#include "pm-image-io.hpp"
+#include "pm-image-store.hpp"
+
+#include <QImageReader>
+#include <QPromise>
+
+#include <memory>
+
+#include <obs-module.h>
+
+PmImageIo::PmImageIo()
+{
+    m_pool.setObjectName("pixel match image io");
+}
+
+PmImageIo::~PmImageIo()
+{
+    waitForDone();
+}
+
+void PmImageIo::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+QFuture<PmDecodedImage> PmImageIo::decode(const std::string &filename)
+{
+    auto promise = std::make_shared<QPromise<PmDecodedImage>>();
+    QFuture<PmDecodedImage> future = promise->future();
+    promise->start();
+
+    const PmImageCache *cache = &m_cache;
+    m_pool.start([promise, filename, cache]() {
+        if (promise->isCanceled()) {
+            promise->finish();
+            return;
+        }
+
+        // a current cache entry skips decoding and hashing altogether
+        QFileInfo source(QString::fromStdString(filename));
+        PmDecodedImage decoded = cache->load(source);
+        if (!decoded.image.isNull()) {
+            promise->addResult(decoded);
+            promise->finish();
+            return;
+        }
+
+        QImageReader reader(source.filePath());
+        QImage img = reader.read();
+        if (img.isNull()) {
+            blog(LOG_WARNING, "Unable to open filename: %s (%s)",
+                 filename.data(), reader.errorString().toUtf8().data());
+        } else if (img.format() != QImage::Format_ARGB32) {
+            img.convertTo(QImage::Format_ARGB32);
+            if (img.isNull()) {
+                blog(LOG_WARNING, "Image conversion failed: %s",
+                     filename.data());
+            }
+        }
+        decoded.hash = PmImageStore::contentHash(img);
+        decoded.alphaRegion = PmImageStore::alphaRegion(img);
+        decoded.image = img;
+        cache->store(source, decoded);
+        promise->addResult(decoded);
+        promise->finish();
+    });
+    return future;
+}
+
+QFuture<bool> PmImageIo::encode(const QImage &image, const QString &filename)
+{
+    auto promise = std::make_shared<QPromise<bool>>();
+    QFuture<bool> future = promise->future();
+    promise->start();
+
+    m_pool.start([promise, image, filename]() {
+        if (promise->isCanceled()) {
+            promise->finish();
+            return;
+        }
+
+        bool ok = image.save(filename);
+        if (!ok) {
+            blog(LOG_WARNING, "Unable to save file: %s",
+                 filename.toUtf8().data());
+        }
+        promise->addResult(ok);
+        promise->finish();
+    });
+    return future;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QFuture>
+#include <QImage>
+#include <QString>
+#include <QThreadPool>
+
+#include <string>
+
+#include "pm-image-cache.hpp"
+
+/**
+ * @brief Decodes and encodes match images on a thread pool. Decoded images
+ *        arrive in Format_ARGB32, the layout the filter uploads, and are
+ *        served from the on-disk cache when it holds a current entry.
+ *        Canceling a future before its job starts skips the job entirely.
+ */
+class PmImageIo
+{
+public:
+    PmImageIo();
+    ~PmImageIo();
+
+    // result is a null image when the file can't be read or converted
+    QFuture<PmDecodedImage> decode(const std::string &filename);
+    QFuture<bool> encode(const QImage &image, const QString &filename);
+
+    void waitForDone();
+
+protected:
+    QThreadPool m_pool;
+    PmImageCache m_cache;
+};
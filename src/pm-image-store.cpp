@@ -0,0 +1,134 @@
+#include "pm-image-store.hpp"
+
+#include <algorithm>
+
+uint64_t PmImageStore::contentHash(const QImage &image)
+{
+    size_t sz = (size_t)(image.bytesPerLine()) * (size_t)(image.height());
+    if (!sz)
+        return 0;
+
+    size_t seed = (size_t(image.width()) << 16) ^ size_t(image.height());
+    return uint64_t(qHashBits(image.constBits(), sz, seed));
+}
+
+QRect PmImageStore::alphaRegion(const QImage &image)
+{
+    int left = image.width(), right = -1;
+    int top = image.height(), bottom = -1;
+    for (int y = 0; y < image.height(); ++y) {
+        auto line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (qAlpha(line[x]) > 0) {
+                left = std::min(left, x);
+                right = std::max(right, x);
+                top = std::min(top, y);
+                bottom = std::max(bottom, y);
+            }
+        }
+    }
+
+    // nothing is active; the whole image is compared
+    if (right < 0)
+        return image.rect();
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void PmImageStore::addRefs(const PmMultiMatchConfig &mcfg)
+{
+    for (const auto &cfg : mcfg) {
+        addRef(cfg.matchImgFilename);
+    }
+}
+
+void PmImageStore::removeRefs(const PmMultiMatchConfig &mcfg)
+{
+    for (const auto &cfg : mcfg) {
+        removeRef(cfg.matchImgFilename);
+    }
+}
+
+void PmImageStore::addRef(const std::string &filename)
+{
+    if (filename.empty())
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    m_fileRefs[filename]++;
+}
+
+void PmImageStore::removeRef(const std::string &filename)
+{
+    if (filename.empty())
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    auto find = m_fileRefs.find(filename);
+    if (find != m_fileRefs.end() && --(*find) <= 0)
+        m_fileRefs.erase(find);
+}
+
+int PmImageStore::refCount(const std::string &filename) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_fileRefs.value(filename, 0);
+}
+
+bool PmImageStore::isOrphaned(const PmMatchConfig &cfg) const
+{
+    return cfg.wasDownloaded && cfg.matchImgFilename.size()
+        && refCount(cfg.matchImgFilename) == 0;
+}
+
+QSet<std::string> PmImageStore::orphanedImages(
+    const PmMultiMatchConfig &mcfg) const
+{
+    QSet<std::string> ret;
+    for (const auto &cfg : mcfg) {
+        if (isOrphaned(cfg))
+            ret.insert(cfg.matchImgFilename);
+    }
+    return ret;
+}
+
+QImage PmImageStore::share(const PmDecodedImage &decoded)
+{
+    const QImage &image = decoded.image;
+    uint64_t hash = decoded.hash;
+    if (image.isNull())
+        return image;
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_images.begin(); it != m_images.end();) {
+        if (it->isDetached()) {
+            m_infos.remove(it->cacheKey());
+            it = m_images.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto find = m_images.find(hash);
+    if (find != m_images.end()) {
+        if (find->size() == image.size() && find->format() == image.format())
+            return *find;
+        m_infos.remove(find->cacheKey());
+    }
+    m_images[hash] = image;
+    m_infos[image.cacheKey()] = {hash, decoded.alphaRegion};
+    return image;
+}
+
+uint64_t PmImageStore::hashOf(const QImage &image) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto find = m_infos.find(image.cacheKey());
+    return find != m_infos.end() ? find->hash : 0;
+}
+
+QRect PmImageStore::alphaRegionOf(const QImage &image) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto find = m_infos.find(image.cacheKey());
+    return find != m_infos.end() ? find->alphaRegion : QRect();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+
+#include <string>
+
+#include "pm-structs.hpp"
+#include "pm-image-cache.hpp"
+
+/**
+ * @brief Keeps one copy of each distinct match image, keyed by content hash,
+ *        so entries showing the same pixels share a buffer. Also counts how
+ *        often each image file is referenced by the active configuration and
+ *        the presets; a downloaded file without references is an orphan.
+ */
+class PmImageStore
+{
+public:
+    static uint64_t contentHash(const QImage &image);
+    static QRect alphaRegion(const QImage &image);
+
+    // image file references
+    void addRefs(const PmMultiMatchConfig &mcfg);
+    void removeRefs(const PmMultiMatchConfig &mcfg);
+    void addRef(const std::string &filename);
+    void removeRef(const std::string &filename);
+    int refCount(const std::string &filename) const;
+    bool isOrphaned(const PmMatchConfig &cfg) const;
+    QSet<std::string> orphanedImages(const PmMultiMatchConfig &mcfg) const;
+
+    // returns the stored image with identical content, or stores this one;
+    // images nobody else holds on to are dropped along the way
+    QImage share(const PmDecodedImage &decoded);
+    uint64_t hashOf(const QImage &image) const;
+    QRect alphaRegionOf(const QImage &image) const; // null when unknown
+
+protected:
+    struct ImageInfo
+    {
+        uint64_t hash;
+        QRect alphaRegion;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<std::string, int> m_fileRefs;
+    QHash<uint64_t, QImage> m_images;
+    QHash<qint64, ImageInfo> m_infos; // by QImage::cacheKey()
+};
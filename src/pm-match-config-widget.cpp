@@ -231,7 +231,7 @@ PmMatchConfigWidget::PmMatchConfigWidget(PmCore *pixelMatcher, QWidget *parent)
 
     // local signals -> core
     connect(this, &PmMatchConfigWidget::sigMatchConfigChanged,
-            m_core, &PmCore::onMatchConfigChanged, qc);
+            m_core, &PmCore::onMatchConfigEdited, qc);
     connect(this, &PmMatchConfigWidget::sigCaptureStateChanged,
             m_core, &PmCore::onCaptureStateChanged, qc);
     connect(this, &PmMatchConfigWidget::sigRefreshMatchImage,
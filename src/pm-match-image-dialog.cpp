@@ -1,5 +1,6 @@
 #include "pm-match-image-dialog.hpp"
 #include "pm-image-view.hpp"
+#include "pm-image-io.hpp"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -8,8 +9,9 @@
 #include <QMessageBox>
 
 PmMatchImageDialog::PmMatchImageDialog(
-    const QImage& image, QWidget* parent)
+    PmImageIo &imageIo, const QImage& image, QWidget* parent)
 : QDialog(parent)
+, m_imageIo(imageIo)
 , m_image(image)
 {
     setWindowTitle(obs_module_text("Match Image Preview"));
@@ -18,19 +20,19 @@ PmMatchImageDialog::PmMatchImageDialog(
     PmImageView* imageView = new PmImageView(image, this);
 
     // save buttons
-    QPushButton* saveButton = new QPushButton(
+    m_saveButton = new QPushButton(
         obs_module_text("Save"), this);
-    connect(saveButton, &QPushButton::released,
+    connect(m_saveButton, &QPushButton::released,
             this, &PmMatchImageDialog::onSaveReleased, Qt::QueuedConnection);
 
-    QPushButton* cancelButton = new QPushButton(
+    m_cancelButton = new QPushButton(
         obs_module_text("Cancel"), this);
-    connect(cancelButton, &QPushButton::released,
+    connect(m_cancelButton, &QPushButton::released,
             this, &QDialog::reject, Qt::QueuedConnection);
 
     QHBoxLayout* buttonsLayout = new QHBoxLayout;
-    buttonsLayout->addWidget(saveButton);
-    buttonsLayout->addWidget(cancelButton);
+    buttonsLayout->addWidget(m_saveButton);
+    buttonsLayout->addWidget(m_cancelButton);
 
     // put it all together
     QVBoxLayout* mainLayout = new QVBoxLayout();
@@ -50,15 +52,28 @@ void PmMatchImageDialog::onSaveReleased()
         PmConstants::k_imageFilenameFilter);
 
     if (saveFilename.size()) {
-        bool ok = m_image.save(saveFilename);
-        if (ok) {
-            m_saveLocation = std::string(saveFilename.toUtf8());
-            accept();
-        } else {
-            QString errMsg = QString(
-                obs_module_text("Unable to save file: %1")).arg(saveFilename);
-            QMessageBox::critical(
-                this, obs_module_text("Error"), errMsg);
-        }
+        // encoding runs in the background; the dialog stays responsive
+        m_saveButton->setEnabled(false);
+        m_cancelButton->setEnabled(false);
+        m_imageIo.encode(m_image, saveFilename).then(this,
+            [this, saveFilename](bool ok) {
+                onSaveFinished(saveFilename, ok);
+            });
+    }
+}
+
+void PmMatchImageDialog::onSaveFinished(const QString &saveFilename, bool ok)
+{
+    m_saveButton->setEnabled(true);
+    m_cancelButton->setEnabled(true);
+
+    if (ok) {
+        m_saveLocation = std::string(saveFilename.toUtf8());
+        accept();
+    } else {
+        QString errMsg = QString(
+            obs_module_text("Unable to save file: %1")).arg(saveFilename);
+        QMessageBox::critical(
+            this, obs_module_text("Error"), errMsg);
     }
 }
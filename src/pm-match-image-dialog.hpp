@@ -8,6 +8,9 @@
 
 #include "pm-structs.hpp"
 
+class PmImageIo;
+class QPushButton;
+
 /**
  * @brief Widget for presenting a match image to user to initiate saving or
  *        rejection
@@ -17,13 +20,19 @@ class PmMatchImageDialog : public QDialog
     Q_OBJECT
 
 public:
-    PmMatchImageDialog(const QImage& image, QWidget *parent = nullptr);
+    PmMatchImageDialog(PmImageIo &imageIo, const QImage& image,
+                       QWidget *parent = nullptr);
     const std::string& saveLocation() const { return m_saveLocation; }
 
 protected slots:
     void onSaveReleased();
 
 protected:
+    void onSaveFinished(const QString &saveFilename, bool ok);
+
+    PmImageIo &m_imageIo;
     std::string m_saveLocation;
     QImage m_image;
+    QPushButton* m_saveButton;
+    QPushButton* m_cancelButton;
 };
\ No newline at end of file
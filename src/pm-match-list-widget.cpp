@@ -152,7 +152,7 @@ PmMatchListWidget::PmMatchListWidget(
 
     // connections: this -> core
     connect(this, &PmMatchListWidget::sigMatchConfigChanged,
-        m_core, &PmCore::onMatchConfigChanged, qc);
+        m_core, &PmCore::onMatchConfigEdited, qc);
     connect(this, &PmMatchListWidget::sigMatchConfigSelect,
         m_core, &PmCore::onMatchConfigSelect, qc);
     connect(this, &PmMatchListWidget::sigMatchConfigMoveUp,
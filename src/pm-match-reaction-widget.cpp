@@ -180,7 +180,7 @@ PmActionEntryWidget::PmActionEntryWidget(
             this, &PmActionEntryWidget::onShowTimeFormatHelp);
 
     // init state
-    onScenesChanged();
+    prepareSelections();
     onHotkeySelectionChanged();
 
     onFileStringsChanged();
@@ -828,9 +828,35 @@ void PmActionEntryWidget::onShowTimeFormatHelp()
     }
 }
 
-void PmActionEntryWidget::onScenesChanged()
+void PmActionEntryWidget::onSceneGraphChanged(PmSceneGraphDelta delta)
 {
+    // only targets of this action's type need to be listed again
+    bool affected;
+    switch (m_actionType) {
+    case PmActionType::Scene:
+        affected = delta.scenesChanged;
+        break;
+    case PmActionType::SceneItem:
+    case PmActionType::Filter:
+        affected = delta.scenesChanged || delta.sceneItemsChanged;
+        break;
+    case PmActionType::ToggleMute:
+        affected = delta.audioSourcesChanged;
+        break;
+    default:
+        affected = false;
+        break;
+    }
+    if (!affected)
+        return;
+
+    // keep the selection, unless the target is gone
+    QVariant target = m_targetCombo->currentData();
     prepareSelections();
+    int targetIdx = m_targetCombo->findData(target);
+    m_targetCombo->blockSignals(true);
+    m_targetCombo->setCurrentIndex(targetIdx >= 0 ? targetIdx : 0);
+    m_targetCombo->blockSignals(false);
 }
 
 void PmActionEntryWidget::updateUiStyle(const PmAction &action)
@@ -996,8 +1022,9 @@ void PmMatchReactionWidget::reactionToUi(
             const auto qc = Qt::QueuedConnection;
             entryWidget = new PmActionEntryWidget(m_core, i, this);
             entryWidget->installEventFilterAll(this);
-            connect(m_core, &PmCore::sigScenesChanged,
-                    entryWidget, &PmActionEntryWidget::onScenesChanged, qc);
+            connect(m_core, &PmCore::sigSceneGraphChanged,
+                    entryWidget, &PmActionEntryWidget::onSceneGraphChanged,
+                    qc);
             connect(entryWidget, &PmActionEntryWidget::sigActionChanged,
                     this, &PmMatchReactionWidget::onActionChanged, qc);
 
@@ -43,7 +43,7 @@ signals:
     void sigActionChanged(size_t actionIndex, PmAction action);
 
 public slots:
-    void onScenesChanged();
+    void onSceneGraphChanged(PmSceneGraphDelta delta);
 
 protected slots:
     void onUiChanged();
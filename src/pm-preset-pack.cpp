@@ -0,0 +1,272 @@
+#include "pm-preset-pack.hpp"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+const char *PmPresetPack::k_extension = "pmpack";
+
+// file layout: header, index entries each followed by their name, then the
+// record data in index order
+struct PackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t reserved;
+};
+
+struct PackIndexEntry
+{
+    uint32_t type;
+    uint32_t nameSize;
+    int64_t offset;
+    int64_t size;
+};
+
+enum PackRecordType : uint32_t { PresetRecord = 0, ImageRecord = 1 };
+
+static const uint32_t k_packMagic = 0x4b504d50; // "PMPK"
+static const uint32_t k_packVersion = 1;
+
+static std::runtime_error packError(
+    const char *what, const std::string &filename)
+{
+    std::stringstream oss;
+    oss << what << ": " << filename;
+    return std::runtime_error(oss.str().data());
+}
+
+// images are written out under their record name, so a name must be a plain
+// file name; anything that could reach outside the target folder is refused
+static bool isPlainFileName(const std::string &name)
+{
+    if (name.empty() || name == "." || name.find("..") != std::string::npos
+     || name.find_first_of("/\\:") != std::string::npos)
+        return false;
+
+    QString qname = QString::fromStdString(name);
+    QFileInfo info(qname);
+    return !info.isAbsolute() && info.fileName() == qname;
+}
+
+static std::string packImageName(
+    const QString &baseName, int n, const QString &suffix)
+{
+    QString ret = n ? QString("%1_%2").arg(baseName).arg(n) : baseName;
+    if (suffix.size())
+        ret += '.' + suffix;
+    return ret.toUtf8().data();
+}
+
+bool PmPresetPack::isPack(const std::string &filename)
+{
+    QFile file(filename.data());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    PackHeader header;
+    return file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            == qint64(sizeof(header))
+        && header.magic == k_packMagic;
+}
+
+void PmPresetPack::write(const std::string &filename,
+                         const PmMatchPresets &presets,
+                         const QList<std::string> &selectedPresets)
+{
+    struct PendingRecord
+    {
+        PackRecordType type;
+        std::string name;
+        QByteArray data;
+    };
+    std::vector<PendingRecord> records;
+    QHash<std::string, std::string> imageNames; // by source filename
+    QSet<std::string> usedImageNames;
+
+    for (const auto &presetName : selectedPresets) {
+        auto find = presets.find(presetName);
+        if (find == presets.end())
+            continue;
+
+        // local images are embedded once, however many entries use them
+        PmMultiMatchConfig mcfg = *find;
+        for (PmMatchConfig &cfg : mcfg) {
+            const std::string &imgFilename = cfg.matchImgFilename;
+            QFileInfo info(imgFilename.data());
+            if (imgFilename.empty() || !info.isFile())
+                continue;
+
+            auto findName = imageNames.find(imgFilename);
+            if (findName == imageNames.end()) {
+                QFile imgFile(info.filePath());
+                if (!imgFile.open(QIODevice::ReadOnly))
+                    throw packError("Unable to open file", imgFilename);
+
+                // a name the reader would refuse (e.g. with a colon, which
+                // is fine in local file names) is replaced
+                QString baseName = info.completeBaseName();
+                QString suffix = info.suffix();
+                std::string imageName = info.fileName().toUtf8().data();
+                if (!isPlainFileName(imageName)) {
+                    baseName = "image";
+                    if (!isPlainFileName(suffix.toUtf8().data()))
+                        suffix.clear();
+                    imageName = packImageName(baseName, 0, suffix);
+                }
+                for (int i = 1; usedImageNames.contains(imageName); ++i) {
+                    imageName = packImageName(baseName, i, suffix);
+                }
+                usedImageNames.insert(imageName);
+                findName = imageNames.insert(imgFilename, imageName);
+                records.push_back({ImageRecord, imageName, imgFile.readAll()});
+            }
+            cfg.matchImgFilename = *findName;
+        }
+
+        QByteArray xmlData;
+        QXmlStreamWriter xml(&xmlData);
+        mcfg.saveXml(xml, presetName);
+        records.push_back({PresetRecord, presetName, xmlData});
+    }
+
+    // presets go first, so that reading the index and presets stays within
+    // the beginning of the file
+    std::stable_sort(records.begin(), records.end(),
+        [](const PendingRecord &a, const PendingRecord &b) {
+            return a.type < b.type;
+        });
+
+    int64_t offset = sizeof(PackHeader);
+    for (const auto &record : records) {
+        offset += sizeof(PackIndexEntry) + record.name.size();
+    }
+
+    QSaveFile file(filename.data());
+    if (!file.open(QIODevice::WriteOnly))
+        throw packError("Unable to open file", filename);
+
+    PackHeader header = {k_packMagic, k_packVersion,
+                         uint32_t(records.size()), 0};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto &record : records) {
+        PackIndexEntry entry = {record.type, uint32_t(record.name.size()),
+                                offset, record.data.size()};
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        file.write(record.name.data(), qint64(record.name.size()));
+        offset += record.data.size();
+    }
+    for (const auto &record : records) {
+        file.write(record.data);
+    }
+
+    if (!file.commit())
+        throw packError("Unable to write file", filename);
+}
+
+PmPresetPack::PmPresetPack(const std::string &filename)
+: m_file(filename.data())
+{
+    if (!m_file.open(QIODevice::ReadOnly))
+        throw packError("Unable to open file", filename);
+
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data)
+        throw packError("Unable to map file", filename);
+
+    PackHeader header;
+    if (m_size < qint64(sizeof(header)))
+        throw packError("Not a preset pack", filename);
+    memcpy(&header, m_data, sizeof(header));
+    if (header.magic != k_packMagic)
+        throw packError("Not a preset pack", filename);
+    if (header.version != k_packVersion)
+        throw packError("Unsupported preset pack version", filename);
+
+    qint64 pos = sizeof(header);
+    for (uint32_t i = 0; i < header.numEntries; ++i) {
+        PackIndexEntry entry;
+        if (pos + qint64(sizeof(entry)) > m_size)
+            throw packError("Truncated preset pack", filename);
+        memcpy(&entry, m_data + pos, sizeof(entry));
+        pos += sizeof(entry);
+
+        if (pos + qint64(entry.nameSize) > m_size
+         || entry.offset < 0 || entry.size < 0
+         || entry.offset > m_size - entry.size)
+            throw packError("Truncated preset pack", filename);
+        std::string name(
+            reinterpret_cast<const char*>(m_data + pos), entry.nameSize);
+        pos += entry.nameSize;
+
+        if (name.empty())
+            throw packError("Unnamed record in preset pack", filename);
+        if (entry.type == ImageRecord && !isPlainFileName(name))
+            throw packError("Invalid image name in preset pack", filename);
+
+        Record record = {entry.offset, entry.size};
+        if (entry.type == PresetRecord) {
+            m_presets.insert(name, record);
+        } else if (entry.type == ImageRecord) {
+            m_images.insert(name, record);
+        }
+    }
+}
+
+QByteArray PmPresetPack::recordData(const Record &record) const
+{
+    // no copy; the data stays valid as long as the pack is open
+    return QByteArray::fromRawData(
+        reinterpret_cast<const char*>(m_data + record.offset),
+        qsizetype(record.size));
+}
+
+PmMultiMatchConfig PmPresetPack::preset(const std::string &name) const
+{
+    auto find = m_presets.find(name);
+    if (find == m_presets.end())
+        return PmMultiMatchConfig();
+
+    QXmlStreamReader reader(recordData(*find));
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()
+         && reader.name() == QLatin1String("preset")) {
+            std::string presetName;
+            return PmMultiMatchConfig(reader, presetName);
+        }
+    }
+    return PmMultiMatchConfig();
+}
+
+PmMatchPresets PmPresetPack::presets() const
+{
+    PmMatchPresets ret;
+    for (auto it = m_presets.begin(); it != m_presets.end(); ++it) {
+        ret.insert(it.key(), preset(it.key()));
+    }
+    return ret;
+}
+
+bool PmPresetPack::extractImage(
+    const std::string &imageName, const std::string &destFilename) const
+{
+    auto find = m_images.find(imageName);
+    if (find == m_images.end())
+        return false;
+
+    QSaveFile file(destFilename.data());
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(recordData(*find));
+    return file.commit();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+
+#include <string>
+
+#include "pm-structs.hpp"
+
+/**
+ * @brief Single-file preset pack: an index, then each preset as XML, then
+ *        the image files the presets use, stored verbatim. Opening a pack
+ *        maps the file and reads only the index; presets are parsed and
+ *        images are written out only when asked for.
+ */
+class PmPresetPack
+{
+public:
+    static const char *k_extension;
+
+    static bool isPack(const std::string &filename);
+    // presets refer to their images by name inside the pack; images that
+    // aren't local files (e.g. URLs) are left as references
+    static void write(const std::string &filename,
+                      const PmMatchPresets &presets,
+                      const QList<std::string> &selectedPresets);
+
+    PmPresetPack(const std::string &filename); // throws when unreadable
+
+    QList<std::string> presetNames() const { return m_presets.keys(); }
+    PmMultiMatchConfig preset(const std::string &name) const;
+    PmMatchPresets presets() const;
+
+    bool containsImage(const std::string &imageName) const
+        { return m_images.contains(imageName); }
+    bool extractImage(const std::string &imageName,
+                      const std::string &destFilename) const;
+
+protected:
+    struct Record
+    {
+        qint64 offset;
+        qint64 size;
+    };
+
+    QByteArray recordData(const Record &record) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    QHash<std::string, Record> m_presets;
+    QHash<std::string, Record> m_images;
+};
@@ -133,6 +133,8 @@ PmPresetsWidget::PmPresetsWidget(PmCore* core, QWidget* parent)
             m_core, &PmCore::onMatchPresetsImport, qc);
     connect(this, &PmPresetsWidget::sigMatchPresetsAppend,
             m_core, &PmCore::onMatchPresetsAppend, qc);
+    connect(this, &PmPresetsWidget::sigMatchPresetsImportFinished,
+            m_core, &PmCore::onMatchPresetsImportFinished, qc);
     connect(this, &PmPresetsWidget::sigMatchImagesRemove,
             m_core, &PmCore::onMatchImagesRemove, qc);
 
@@ -205,14 +207,17 @@ void PmPresetsWidget::onPresetsImportAvailable(PmMatchPresets availablePresets)
             obs_module_text("Presets to Import"),
             availablePresets.keys(), availablePresets.keys(), this);
         selectedPresets = selector.selectedChoices();
-        if (selector.result() == QFileDialog::Rejected
-         || selectedPresets.empty())
-            return;
+        if (selector.result() == QFileDialog::Rejected)
+            selectedPresets.clear();
     } else {
         selectedPresets = availablePresets.keys();
     }
 
-    importPresets(availablePresets, selectedPresets);
+    if (selectedPresets.size())
+        importPresets(availablePresets, selectedPresets);
+
+    // queued after any presets that were added
+    emit sigMatchPresetsImportFinished();
 }
 
 void PmPresetsWidget::onPresetsDownloadAvailable(
@@ -384,7 +389,7 @@ void PmPresetsWidget::onPresetExportXml()
 
     QFileDialog saveDialog(
         this, obs_module_text("Export Preset(s) XML"), QString(),
-        PmConstants::k_xmlFilenameFilter);
+        PmConstants::k_presetFilenameFilter);
     QString saveFilename = activePresetName.data();
     saveFilename.replace(PmConstants::k_problemCharacterRegex, "");
     saveDialog.selectFile(saveFilename);
@@ -395,6 +400,10 @@ void PmPresetsWidget::onPresetExportXml()
     if (saveDialog.result() != QDialog::Accepted
      || selectedFiles.empty()) return;
     QString qstrFilename = selectedFiles.first();
+    if (saveDialog.selectedNameFilter().contains("pmpack")
+     && !qstrFilename.endsWith(".pmpack")) {
+        qstrFilename += ".pmpack";
+    }
     std::string filename(qstrFilename.toUtf8().data());
 
     emit sigMatchPresetExport(filename, selectedPresets);
@@ -406,7 +415,7 @@ void PmPresetsWidget::onPresetImportXml()
 
     QString qstrFilename = QFileDialog::getOpenFileName(
         this, obs_module_text("Import Presets(s) XML"), QString(),
-        PmConstants::k_xmlFilenameFilter);
+        PmConstants::k_presetFilenameFilter);
     std::string filename = qstrFilename.toUtf8().data();
     if (filename.size()) {
         emit sigMatchPresetsImport(filename);
@@ -473,9 +482,8 @@ void PmPresetsWidget::importPresets(
         bool skip = false;
         while (m_core->matchPresetExists(presetName)) {
             // preset with this name exists
-            auto existingPreset = m_core->matchPresetByName(presetName);
-            const auto& newPreset = presets[presetName];
-            if (newPreset == existingPreset) {
+            size_t newHash = PmMultiMatchHash(presets[presetName]).value();
+            if (newHash == m_core->matchPresetHash(presetName)) {
                 // it's the same as in existing configuration. don't bother
                 ++numUnchanged;
                 skip = true;
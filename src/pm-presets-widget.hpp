@@ -30,6 +30,7 @@ signals:
     void sigMatchPresetExport(std::string filename, QList<std::string> presets);
     void sigMatchPresetsImport(std::string filename);
     void sigMatchPresetsAppend(PmMatchPresets newPresets);
+    void sigMatchPresetsImportFinished();
     void sigMatchImagesRemove(QList<std::string> filenames);
 
 protected slots:
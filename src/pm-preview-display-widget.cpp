@@ -138,10 +138,8 @@ void PmPreviewDisplayWidget::onActiveFilterChanged(PmFilterRef ref)
     m_activeFilter = ref;
     auto filterData = m_activeFilter.filterData();
     if (filterData) {
-        m_activeFilter.lockData();
-        m_baseWidth = int(filterData->base_width);
-        m_baseHeight = int(filterData->base_height);
-        m_activeFilter.unlockData();
+        m_baseWidth = int(pm_get_base_width(filterData));
+        m_baseHeight = int(pm_get_base_height(filterData));
     } else {
         m_baseWidth = 0;
         m_baseHeight = 0;
@@ -239,10 +237,8 @@ void PmPreviewDisplayWidget::drawFilter()
     if (!renderSrc || !filterData)
         goto done;
 
-    filterRef.lockData();
-    m_baseWidth = int(filterData->base_width);
-    m_baseHeight = int(filterData->base_height);
-    filterRef.unlockData();
+    m_baseWidth = int(pm_get_base_width(filterData));
+    m_baseHeight = int(pm_get_base_height(filterData));
 
     getDisplaySize(vpWidth, vpHeight);
 
@@ -262,27 +258,32 @@ void PmPreviewDisplayWidget::drawFilter()
         vpBottom = 0.0f;
     }
 
-    filterRef.lockData();
-    if (filterData->filter_mode == PM_MASK_BEGIN
-     || filterData->filter_mode == PM_MASK_END
-     || filterData->filter_mode == PM_SNAPSHOT) {
-        // don't mess with these
-        skip = true;
-    } else {
-        switch (captureState) {
-        case PmCaptureState::Inactive:
-            filterData->filter_mode = PM_MATCH_VISUALIZE; break;
-        case PmCaptureState::Automask:
-            filterData->filter_mode = PM_MASK_VISUALIZE; break;
-        case PmCaptureState::Activated:
-        case PmCaptureState::SelectBegin:
-        case PmCaptureState::SelectMoved:
-        case PmCaptureState::SelectFinished:
-        case PmCaptureState::Accepted:
-            filterData->filter_mode = PM_SELECT_REGION_VISUALIZE; break;
+    {
+        auto filterMode = pm_get_filter_mode(filterData);
+        auto visualizeMode = filterMode;
+        if (filterMode == PM_MASK_BEGIN
+         || filterMode == PM_MASK_END
+         || filterMode == PM_SNAPSHOT) {
+            // don't mess with these
+            skip = true;
+        } else {
+            switch (captureState) {
+            case PmCaptureState::Inactive:
+                visualizeMode = PM_MATCH_VISUALIZE; break;
+            case PmCaptureState::Automask:
+                visualizeMode = PM_MASK_VISUALIZE; break;
+            case PmCaptureState::Activated:
+            case PmCaptureState::SelectBegin:
+            case PmCaptureState::SelectMoved:
+            case PmCaptureState::SelectFinished:
+            case PmCaptureState::Accepted:
+                visualizeMode = PM_SELECT_REGION_VISUALIZE; break;
+            }
+            // the core may have requested a capture in the meantime
+            if (!pm_replace_filter_mode(filterData, filterMode, visualizeMode))
+                skip = true;
         }
     }
-    filterRef.unlockData();
 
     if (skip) goto done;
 
@@ -132,27 +132,38 @@ PmAction::PmAction(QXmlStreamReader &reader)
             return;
         }
 
-        QString name = reader.name().toString();
+        PmXmlTag tag = pmXmlTag(reader);
         if (reader.isEndElement()) {
-            if (name == "action") {
+            if (tag == PmXmlTag::Action) {
                 return;
             }
         } else if (reader.isStartElement()) {
-            QString elementText = reader.readElementText();
-            if (name == "action_type") {
-                actionType = (PmActionType)(elementText.toInt());
-            } else if (name == "action_code") {
-                actionCode = (size_t)elementText.toUInt();
-            } else if (name == "target_element") {
-                targetElement = elementText.toUtf8().data();
-            } else if (name == "target_details") {
-                targetDetails = elementText.toUtf8().data();
-            } else if (name == "hotkey_key") {
-                keyCombo.key = (obs_key_t)elementText.toInt();
-            } else if (name == "hotkey_modifiers") {
-                keyCombo.modifiers = (uint32_t)elementText.toUInt();
-            } else if (name == "date_time_format") {
-                timeFormat = elementText.toUtf8().data();
+            switch (tag) {
+            case PmXmlTag::ActionType:
+                actionType = (PmActionType)(reader.readElementText().toInt());
+                break;
+            case PmXmlTag::ActionCode:
+                actionCode = (size_t)reader.readElementText().toUInt();
+                break;
+            case PmXmlTag::TargetElement:
+                targetElement = pmXmlReadString(reader);
+                break;
+            case PmXmlTag::TargetDetails:
+                targetDetails = pmXmlReadString(reader);
+                break;
+            case PmXmlTag::HotkeyKey:
+                keyCombo.key = (obs_key_t)reader.readElementText().toInt();
+                break;
+            case PmXmlTag::HotkeyModifiers:
+                keyCombo.modifiers
+                    = (uint32_t)reader.readElementText().toUInt();
+                break;
+            case PmXmlTag::DateTimeFormat:
+                timeFormat = pmXmlReadString(reader);
+                break;
+            default:
+                reader.skipCurrentElement();
+                break;
             }
         }
     }
@@ -251,6 +262,23 @@ bool PmAction::operator==(const PmAction &other) const
             timeFormat == other.timeFormat);
 }
 
+size_t PmAction::hash() const
+{
+    std::hash<std::string> strHash;
+    size_t ret = pmHashCombine(size_t(actionType), actionCode);
+    ret = pmHashCombine(ret, strHash(targetElement));
+    ret = pmHashCombine(ret, strHash(targetDetails));
+
+    // same fields as operator==, which ignores them for other types
+    if (actionType == PmActionType::Hotkey) {
+        ret = pmHashCombine(ret, size_t(keyCombo.key));
+        ret = pmHashCombine(ret, size_t(keyCombo.modifiers));
+    } else if (actionType == PmActionType::File) {
+        ret = pmHashCombine(ret, strHash(timeFormat));
+    }
+    return ret;
+}
+
 QString PmAction::actionColorStr() const
 {
     return actionColorStr(actionType);
@@ -307,23 +335,28 @@ PmReaction::PmReaction(QXmlStreamReader &reader)
             return;
         }
 
-        QString name = reader.name().toString();
+        PmXmlTag tag = pmXmlTag(reader);
         if (reader.isEndElement()) {
-            if (name == "reaction") {
+            if (tag == PmXmlTag::Reaction) {
                 return;
             }
         } else if (reader.isStartElement()) {
-            if (name == "match_actions") {
-                readActionsXml(reader, "match_actions", matchActions);
-            } else if (name == "unmatch_actions") {
-                readActionsXml(reader, "unmatch_actions", unmatchActions);
-            } else {
-                QString elemText = reader.readElementText();
-                if (name == "linger_ms") {
-                    lingerMs = (uint32_t)elemText.toInt();
-                } else if (name == "cooldown_ms") {
-                    cooldownMs = (uint32_t)elemText.toInt();
-                }
+            switch (tag) {
+            case PmXmlTag::MatchActions:
+                readActionsXml(reader, tag, matchActions);
+                break;
+            case PmXmlTag::UnmatchActions:
+                readActionsXml(reader, tag, unmatchActions);
+                break;
+            case PmXmlTag::LingerMs:
+                lingerMs = (uint32_t)reader.readElementText().toInt();
+                break;
+            case PmXmlTag::CooldownMs:
+                cooldownMs = (uint32_t)reader.readElementText().toInt();
+                break;
+            default:
+                reader.skipCurrentElement();
+                break;
             }
         }
     }
@@ -370,6 +403,27 @@ bool PmReaction::renameElement(PmActionType actionType,
     return ret;
 }
 
+bool PmReaction::renameElements(
+    PmActionType actionType, const PmRenameMap &renames)
+{
+    if (renames.empty())
+        return false;
+
+    bool ret = false;
+    for (auto actions : {&matchActions, &unmatchActions}) {
+        for (PmAction &action : *actions) {
+            if (action.actionType != actionType)
+                continue;
+            auto find = renames.find(action.targetElement);
+            if (find != renames.end()) {
+                action.targetElement = find->second;
+                ret = true;
+            }
+        }
+    }
+    return ret;
+}
+
 bool PmReaction::hasAction(PmActionType actionType) const
 {
     for (const PmAction& action : matchActions) {
@@ -432,6 +486,20 @@ bool PmReaction::operator==(const PmReaction &other) const
         && unmatchActions == other.unmatchActions;
 }
 
+size_t PmReaction::hash() const
+{
+    size_t ret = pmHashCombine(lingerMs, cooldownMs);
+    ret = pmHashCombine(ret, matchActions.size());
+    for (const auto &action : matchActions) {
+        ret = pmHashCombine(ret, action.hash());
+    }
+    ret = pmHashCombine(ret, unmatchActions.size());
+    for (const auto &action : unmatchActions) {
+        ret = pmHashCombine(ret, action.hash());
+    }
+    return ret;
+}
+
 void PmReaction::getMatchScene(
     std::string &sceneName, std::string &transition) const
 {
@@ -476,7 +544,7 @@ obs_data_array_t *PmReaction::writeActionArray(const std::vector<PmAction> &vec)
 }
 
 void PmReaction::readActionsXml(QXmlStreamReader &reader,
-    const std::string &vecName, std::vector<PmAction> &vec)
+    PmXmlTag vecTag, std::vector<PmAction> &vec)
 {
     while (true) {
         reader.readNext();
@@ -485,14 +553,13 @@ void PmReaction::readActionsXml(QXmlStreamReader &reader,
             return;
         }
 
-        QString name = reader.name().toString();
         if (reader.isEndElement()) {
-            if (name == vecName.data()) {
+            if (pmXmlTag(reader) == vecTag) {
                 return;
             }
-        } else if (reader.isStartElement() && name == "action") {
-            PmAction action(reader);
-            vec.push_back(action);
+        } else if (reader.isStartElement()
+                && pmXmlTag(reader) == PmXmlTag::Action) {
+            vec.emplace_back(reader);
         }
     }
 }
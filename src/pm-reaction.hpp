@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <functional>
 #include <obs-data.h>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -11,6 +13,14 @@
 #include <obs-module.h>
 #include <obs-hotkey.h>
 
+#include "pm-xml.hpp"
+
+/** @brief Mixes value into a running structural hash */
+inline size_t pmHashCombine(size_t seed, size_t value)
+{
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
 /**
  * @brief Types of reactions provided by the plugin
  */
@@ -84,6 +94,7 @@ public:
     bool isSet() const;
     bool operator==(const PmAction &) const;
     bool operator!=(const PmAction &other) const { return !operator==(other); }
+    size_t hash() const; // equal actions hash equally
     QString actionColorStr() const;
     std::string formattedFileString(const std::string &str,
         const std::string &cfgLabel, const QDateTime &time) const;
@@ -100,6 +111,12 @@ public:
     std::string timeFormat;
 };
 
+/**
+ * @brief Old element names mapped to new ones; an empty new name means
+ *        the element is gone
+ */
+typedef std::unordered_map<std::string, std::string> PmRenameMap;
+
 /**
  * @brief Describes what should happen when an entry is matched or unmatched
  */
@@ -113,6 +130,7 @@ struct PmReaction
     void saveXml(QXmlStreamWriter &writer) const;
     bool renameElement(PmActionType actionType,
         const std::string &oldName, const std::string &newName);
+    bool renameElements(PmActionType actionType, const PmRenameMap &renames);
 
     bool hasAction(PmActionType actionType) const;
     bool hasMatchAction(PmActionType actionType) const;
@@ -123,6 +141,7 @@ struct PmReaction
 
     bool isSet() const;
     bool operator==(const PmReaction &) const;
+    size_t hash() const;
     bool operator!=(const PmReaction &other) const
         { return !operator==(other); }
     size_t matchSz() const { return matchActions.size(); }
@@ -138,7 +157,7 @@ protected:
     static void readActionArray(obs_data_t *a, void *param);
     static obs_data_array_t *writeActionArray(const std::vector<PmAction> &vec);
     static void readActionsXml(QXmlStreamReader &reader,
-        const std::string &vecName, std::vector<PmAction> &vec);
+        PmXmlTag vecTag, std::vector<PmAction> &vec);
     static void writeActionsXml(QXmlStreamWriter &writer,
         const std::string &vecName, const std::vector<PmAction> &vec);
 };
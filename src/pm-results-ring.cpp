@@ -0,0 +1,36 @@
+#include "pm-results-ring.hpp"
+
+bool PmResultsRing::publish()
+{
+    auto &slot = m_slots[m_writeIdx];
+    slot.seq = m_producedSeq.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    int prev = m_latest.exchange(
+        m_writeIdx | k_freshBit, std::memory_order_acq_rel);
+    m_writeIdx = prev & k_idxMask;
+
+    // the consumer only needs to be woken up once until it catches up
+    return !m_notifyPending.exchange(true, std::memory_order_acq_rel);
+}
+
+const PmResultsRing::Slot *PmResultsRing::takeLatest()
+{
+    m_notifyPending.store(false, std::memory_order_release);
+
+    if (!(m_latest.load(std::memory_order_acquire) & k_freshBit)) {
+        // woken up, but the latest frame was already taken
+        m_numStale.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    int prev = m_latest.exchange(m_readIdx, std::memory_order_acq_rel);
+    m_readIdx = prev & k_idxMask;
+
+    const Slot &slot = m_slots[m_readIdx];
+    if (slot.seq > m_lastTakenSeq + 1) {
+        m_numDropped.fetch_add(
+            slot.seq - m_lastTakenSeq - 1, std::memory_order_relaxed);
+    }
+    m_lastTakenSeq = slot.seq;
+    return &slot;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pm-structs.hpp"
+
+#include <atomic>
+
+/**
+ * @brief Hands results of the latest frame from the render thread to
+ *        PmCore. Single producer, single consumer: three slots rotate
+ *        between the producer, the consumer and a shared "latest" position,
+ *        so neither side ever waits for the other. Frames the consumer
+ *        didn't get to are overwritten and counted as dropped.
+ */
+class PmResultsRing
+{
+public:
+    struct Slot
+    {
+        uint64_t seq = 0;
+        PmMultiMatchResults results;
+    };
+
+    PmResultsRing() {}
+
+    // producer side
+    Slot &writeSlot() { return m_slots[m_writeIdx]; }
+    bool publish();
+
+    // consumer side
+    const Slot *takeLatest();
+
+    uint64_t numProduced() const { return m_producedSeq.load(); }
+    uint64_t numDropped() const { return m_numDropped.load(); }
+    uint64_t numStale() const { return m_numStale.load(); }
+
+protected:
+    static const int k_freshBit = 4;
+    static const int k_idxMask = 3;
+
+    Slot m_slots[3];
+    int m_writeIdx = 0;
+    std::atomic<int> m_latest{1};
+    int m_readIdx = 2;
+
+    std::atomic<bool> m_notifyPending{false};
+    std::atomic<uint64_t> m_producedSeq{0};
+    uint64_t m_lastTakenSeq = 0;
+    std::atomic<uint64_t> m_numDropped{0};
+    std::atomic<uint64_t> m_numStale{0};
+};
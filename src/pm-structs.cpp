@@ -1,6 +1,7 @@
 #include "pm-structs.hpp"
 #include "pm-filter-ref.hpp"
 #include "pm-version.hpp"
+#include "pm-xml.hpp"
 
 #include <QXmlStreamWriter>
 #include <QFile>
@@ -64,6 +65,29 @@ bool PmMatchConfig::operator==(const PmMatchConfig &other) const
         && reaction == other.reaction;
 }
 
+size_t PmMatchConfig::hash() const
+{
+    std::hash<std::string> strHash;
+    std::hash<float> floatHash;
+    size_t ret = strHash(matchImgFilename);
+    ret = pmHashCombine(ret, size_t(wasDownloaded));
+    ret = pmHashCombine(ret, strHash(label));
+    ret = pmHashCombine(ret, floatHash(totalMatchThresh));
+    ret = pmHashCombine(ret, size_t(invertResult));
+    ret = pmHashCombine(ret, size_t(maskMode));
+
+    ret = pmHashCombine(ret, size_t(filterCfg.is_enabled));
+    ret = pmHashCombine(ret, size_t(filterCfg.roi_left));
+    ret = pmHashCombine(ret, size_t(filterCfg.roi_bottom));
+    ret = pmHashCombine(ret, floatHash(filterCfg.per_pixel_err_thresh));
+    ret = pmHashCombine(ret, size_t(filterCfg.mask_alpha));
+    ret = pmHashCombine(ret, floatHash(filterCfg.mask_color.x));
+    ret = pmHashCombine(ret, floatHash(filterCfg.mask_color.y));
+    ret = pmHashCombine(ret, floatHash(filterCfg.mask_color.z));
+
+    return pmHashCombine(ret, reaction.hash());
+}
+
 PmMatchConfig::PmMatchConfig(obs_data_t *data)
 {
     memset(&filterCfg, 0, sizeof(pm_match_entry_config));
@@ -124,45 +148,62 @@ PmMatchConfig::PmMatchConfig(QXmlStreamReader &reader)
             return;
         }
 
-        QString name = reader.name().toString();
+        PmXmlTag tag = pmXmlTag(reader);
         if (reader.isEndElement()) {
-            if (name == "match_config") {
+            if (tag == PmXmlTag::MatchConfig) {
                 return;
             }
         } else if (reader.isStartElement()) {
-            if (name == "reaction") {
+            switch (tag) {
+            case PmXmlTag::Reaction:
                 reaction = PmReaction(reader);
-            } else {
-                QString elemText = reader.readElementText();
-                if (name == "label") {
-                    label = elemText.toUtf8().data();
-                } else if (name == "match_image_filename") {
-                    matchImgFilename = elemText.toUtf8().data();
-                } else if (name == "was_downloaded") {
-                    wasDownloaded = (elemText == "true" ? true : false);
-                } else if (name == "roi_left") {
-                    filterCfg.roi_left = elemText.toInt();
-                } else if (name == "roi_bottom") {
-                    filterCfg.roi_bottom = elemText.toInt();
-                } else if (name == "per_pixel_allowed_error") {
-                    filterCfg.per_pixel_err_thresh = elemText.toFloat();
-                } else if (name == "total_match_threshold") {
-                    totalMatchThresh = elemText.toFloat();
-                } else if (name == "invert_result") {
-                    invertResult = (elemText == "true" ? true : false);
-                } else if (name == "mask_mode") {
-                    maskMode = PmMaskMode(elemText.toInt());
-                } else if (name == "mask_alpha") {
-                    filterCfg.mask_alpha = (elemText == "true" ? true : false);
-                } else if (name == "mask_color_r") {
-                    filterCfg.mask_color.x = elemText.toFloat();
-                } else if (name == "mask_color_g") {
-                    filterCfg.mask_color.y = elemText.toFloat();
-                } else if (name == "mask_color_b") {
-                    filterCfg.mask_color.z = elemText.toFloat();
-                } else if (name == "is_enabled") {
-                    filterCfg.is_enabled = (elemText == "true" ? true : false);
-                }
+                break;
+            case PmXmlTag::Label:
+                label = pmXmlReadString(reader);
+                break;
+            case PmXmlTag::MatchImageFilename:
+                matchImgFilename = pmXmlReadString(reader);
+                break;
+            case PmXmlTag::WasDownloaded:
+                wasDownloaded = pmXmlReadBool(reader);
+                break;
+            case PmXmlTag::RoiLeft:
+                filterCfg.roi_left = reader.readElementText().toInt();
+                break;
+            case PmXmlTag::RoiBottom:
+                filterCfg.roi_bottom = reader.readElementText().toInt();
+                break;
+            case PmXmlTag::PerPixelAllowedError:
+                filterCfg.per_pixel_err_thresh
+                    = reader.readElementText().toFloat();
+                break;
+            case PmXmlTag::TotalMatchThreshold:
+                totalMatchThresh = reader.readElementText().toFloat();
+                break;
+            case PmXmlTag::InvertResult:
+                invertResult = pmXmlReadBool(reader);
+                break;
+            case PmXmlTag::MaskMode:
+                maskMode = PmMaskMode(reader.readElementText().toInt());
+                break;
+            case PmXmlTag::MaskAlpha:
+                filterCfg.mask_alpha = pmXmlReadBool(reader);
+                break;
+            case PmXmlTag::MaskColorR:
+                filterCfg.mask_color.x = reader.readElementText().toFloat();
+                break;
+            case PmXmlTag::MaskColorG:
+                filterCfg.mask_color.y = reader.readElementText().toFloat();
+                break;
+            case PmXmlTag::MaskColorB:
+                filterCfg.mask_color.z = reader.readElementText().toFloat();
+                break;
+            case PmXmlTag::IsEnabled:
+                filterCfg.is_enabled = pmXmlReadBool(reader);
+                break;
+            default:
+                reader.skipCurrentElement();
+                break;
             }
         }
     }
@@ -258,19 +299,18 @@ PmMultiMatchConfig::PmMultiMatchConfig(
             return;
         }
 
-        QString name = reader.name().toString();
+        PmXmlTag tag = pmXmlTag(reader);
         if (reader.isEndElement()) {
-            if (name == "preset") {
+            if (tag == PmXmlTag::Preset) {
                 return;
             }
-        } else {
-            if (name == "name") {
-                presetName = reader.readElementText().toUtf8().data();
-            } else if (name == "reaction") {
+        } else if (reader.isStartElement()) {
+            if (tag == PmXmlTag::Name) {
+                presetName = pmXmlReadString(reader);
+            } else if (tag == PmXmlTag::Reaction) {
                 noMatchReaction = PmReaction(reader);
-            } else if (name == "match_config") {
-                PmMatchConfig cfg(reader);
-                push_back(cfg);
+            } else if (tag == PmXmlTag::MatchConfig) {
+                emplace_back(reader);
             }
         }
     }
@@ -327,19 +367,101 @@ bool PmMultiMatchConfig::operator==(const PmMultiMatchConfig& other) const
     }
 }
 
-bool PmMultiMatchConfig::containsImage(
-    const std::string &imgFilename, size_t exceptIndex) const
+//******************************************************************************
+
+static size_t defaultEntryHash()
 {
-    for (size_t i = 0; i < size(); ++i) {
-        if (i == exceptIndex)
-            continue;
+    static const size_t ret = PmMatchConfig().hash();
+    return ret;
+}
+
+static size_t defaultReactionHash()
+{
+    static const size_t ret = PmReaction().hash();
+    return ret;
+}
+
+PmMultiMatchHash::PmMultiMatchHash()
+    : m_noMatchHash(defaultReactionHash())
+{
+}
 
-        const auto &cfg = at(i);
-        if (cfg.matchImgFilename == imgFilename)
-            return true;
+PmMultiMatchHash::PmMultiMatchHash(const PmMultiMatchConfig &mcfg)
+{
+    m_entryHashes.reserve(mcfg.size());
+    for (const auto &cfg : mcfg) {
+        m_entryHashes.push_back(cfg.hash());
+    }
+    m_noMatchHash = mcfg.noMatchReaction.hash();
+    recombine();
+}
+
+size_t PmMultiMatchHash::entryTerm(size_t idx, size_t entryHash)
+{
+    return pmHashCombine(pmHashCombine(0, idx), entryHash);
+}
+
+void PmMultiMatchHash::recombine()
+{
+    m_entryTerms = 0;
+    m_numNonDefault = 0;
+    for (size_t i = 0; i < m_entryHashes.size(); ++i) {
+        m_entryTerms ^= entryTerm(i, m_entryHashes[i]);
+        if (m_entryHashes[i] != defaultEntryHash())
+            m_numNonDefault++;
     }
+}
+
+void PmMultiMatchHash::setEntry(size_t idx, const PmMatchConfig &cfg)
+{
+    size_t &entryHash = m_entryHashes[idx];
+    if (entryHash != defaultEntryHash())
+        m_numNonDefault--;
+    m_entryTerms ^= entryTerm(idx, entryHash);
+
+    entryHash = cfg.hash();
+
+    if (entryHash != defaultEntryHash())
+        m_numNonDefault++;
+    m_entryTerms ^= entryTerm(idx, entryHash);
+}
 
-    return false;
+void PmMultiMatchHash::insertEntry(size_t idx, const PmMatchConfig &cfg)
+{
+    // entries after idx change position, so their terms are recombined
+    m_entryHashes.insert(m_entryHashes.begin() + int(idx), cfg.hash());
+    recombine();
+}
+
+void PmMultiMatchHash::removeEntry(size_t idx)
+{
+    m_entryHashes.erase(m_entryHashes.begin() + int(idx));
+    recombine();
+}
+
+void PmMultiMatchHash::swapEntries(size_t idxA, size_t idxB)
+{
+    size_t &hashA = m_entryHashes[idxA];
+    size_t &hashB = m_entryHashes[idxB];
+    m_entryTerms ^= entryTerm(idxA, hashA) ^ entryTerm(idxB, hashB);
+    std::swap(hashA, hashB);
+    m_entryTerms ^= entryTerm(idxA, hashA) ^ entryTerm(idxB, hashB);
+}
+
+void PmMultiMatchHash::setNoMatchReaction(const PmReaction &reaction)
+{
+    m_noMatchHash = reaction.hash();
+}
+
+size_t PmMultiMatchHash::value() const
+{
+    size_t ret = pmHashCombine(m_entryHashes.size(), m_entryTerms);
+    return pmHashCombine(ret, m_noMatchHash);
+}
+
+bool PmMultiMatchHash::isDefault() const
+{
+    return m_numNonDefault == 0 && m_noMatchHash == defaultReactionHash();
 }
 
 //******************************************************************************
@@ -400,7 +522,7 @@ void PmMatchPresets::importXml(QXmlStreamReader &xml)
             break;
         }
 
-        if (xml.name().toString() == "preset" && xml.isStartElement()) {
+        if (xml.isStartElement() && pmXmlTag(xml) == PmXmlTag::Preset) {
             std::string presetName;
             PmMultiMatchConfig preset(xml, presetName);
             insert(presetName, preset);
@@ -437,31 +559,6 @@ void PmMatchPresets::exportXml(const std::string &filename,
     xml.writeEndDocument();
 }
 
-bool PmMatchPresets::containsImage(const std::string &imgFilename) const
-{
-    for (const auto &mcfg : values()) {
-        if (mcfg.containsImage(imgFilename)) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-QSet<std::string> PmMatchPresets::orphanedImages(
-    const PmMultiMatchConfig &beingRemoved, const PmMultiMatchConfig* activeCfg)
-{
-    QSet<std::string> ret;
-    for (const auto &rcfg : beingRemoved) {
-        if (rcfg.wasDownloaded && rcfg.matchImgFilename.size()
-        && (!activeCfg || !activeCfg->containsImage(rcfg.matchImgFilename))
-        && !this->containsImage(rcfg.matchImgFilename)) {
-            ret.insert(rcfg.matchImgFilename);
-        }
-    }
-    return ret;
-}
-
 //******************************************************************************
 
 bool PmSourceData::operator==(const PmSourceData &other) const
@@ -513,6 +610,7 @@ void pmRegisterMetaTypes()
     qRegisterMetaType<PmPreviewConfig>("PmPreviewConfig");
     qRegisterMetaType<PmSourceHash>("PmSourceHash");
     qRegisterMetaType<PmSceneItemsHash>("PmSceneItemsHash");
+    qRegisterMetaType<PmSceneGraphDelta>("PmSceneGraphDelta");
     qRegisterMetaType<PmFilterRef>("PmFilterRef");
     qRegisterMetaType<PmCaptureState>("PmCaptureState");
     qRegisterMetaType<PmMultiMatchResults>("PmMultiMatchResults");
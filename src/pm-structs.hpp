@@ -76,6 +76,7 @@ struct PmMatchResults
     uint32_t numMatched = 0;
     float percentageMatched = 0;
     bool isMatched = false;
+    bool isReady = false;
     uint32_t baseWidth = 0, baseHeight = 0;
 };
 
@@ -111,6 +112,7 @@ struct PmMatchConfig
     bool operator==(const PmMatchConfig&) const;
     bool operator!=(const PmMatchConfig& other) const
         { return !operator==(other); }
+    size_t hash() const; // equal configs hash equally
 };
 
 /**
@@ -133,12 +135,41 @@ public:
     bool operator!=(const PmMultiMatchConfig& other) const
         { return !operator==(other); }
 
-    bool containsImage(const std::string &imgFilename,
-                       size_t exceptIndex = (size_t)-1) const;
-
     PmReaction noMatchReaction;
 };
 
+/**
+ * @brief Structural hash of a PmMultiMatchConfig, updated entry by entry as
+ *        the config is edited. Comparing two hashes stands in for a deep
+ *        comparison; editing an entry rehashes only that entry, and moving
+ *        entries around only recombines the stored entry hashes.
+ */
+class PmMultiMatchHash
+{
+public:
+    PmMultiMatchHash();
+    PmMultiMatchHash(const PmMultiMatchConfig &mcfg);
+
+    void setEntry(size_t idx, const PmMatchConfig &cfg);
+    void insertEntry(size_t idx, const PmMatchConfig &cfg);
+    void removeEntry(size_t idx);
+    void swapEntries(size_t idxA, size_t idxB);
+    void setNoMatchReaction(const PmReaction &reaction);
+
+    size_t value() const;
+    // every entry and the no-match reaction are at their defaults
+    bool isDefault() const;
+
+protected:
+    static size_t entryTerm(size_t idx, size_t entryHash);
+    void recombine();
+
+    std::vector<size_t> m_entryHashes;
+    size_t m_noMatchHash;
+    size_t m_entryTerms = 0;
+    size_t m_numNonDefault = 0;
+};
+
 /**
  * @bries Stores multiple PmMultiMatchConfig that are easily referenced by a
  *        preset name
@@ -153,12 +184,6 @@ public:
     void exportXml(const std::string &filename,
                    const QList<std::string> &selectedPresets) const;
 
-    bool containsImage(const std::string &imgFilename) const;
-
-    QSet<std::string> orphanedImages(
-        const PmMultiMatchConfig &beingRemoved,
-        const PmMultiMatchConfig* activeCfg = nullptr);
-
 protected:
     void importXml(QXmlStreamReader &reader);
 };
@@ -212,6 +237,23 @@ public:
     PmSceneItemsHash& operator=(const PmSceneItemsHash& other) = default;
 };
 
+/**
+ * @brief What a scene graph scan found to be different from the previous
+ *        one. Structure can change without any names being added or
+ *        removed, e.g. when a scene item moves to another scene.
+ */
+struct PmSceneGraphDelta
+{
+    bool scenesChanged = false;
+    bool sceneItemsChanged = false; // includes filters
+    bool audioSourcesChanged = false;
+
+    QList<std::string> addedScenes, removedScenes;
+    QList<std::string> addedSceneItems, removedSceneItems;
+    QList<std::string> addedFilters, removedFilters;
+    QList<std::string> addedAudioSources, removedAudioSources;
+};
+
 /**
  * @brief Configuration for the preview state of the dialog.
  * 
@@ -240,6 +282,8 @@ namespace PmConstants
         = "PNG (*.png);; JPEG (*.jpg *.jpeg);; BMP (*.bmp);; All files (*.*)";
     const QString k_xmlFilenameFilter
         = "XML (*.xml);; All files (*.*)";
+    const QString k_presetFilenameFilter
+        = "XML (*.xml);; Preset Pack (*.pmpack);; All files (*.*)";
     const QString k_writeFilenameFilter
         = "TXT (*.txt);; LOG (*.log);; All files (*.*)";
 
@@ -0,0 +1,88 @@
+#include "pm-xml.hpp"
+
+#include <QStringEncoder>
+
+#include <algorithm>
+#include <vector>
+
+struct PmXmlTagName
+{
+    QLatin1String name;
+    PmXmlTag tag;
+};
+
+static const std::vector<PmXmlTagName> &sortedTagNames()
+{
+    static const std::vector<PmXmlTagName> ret = []() {
+        std::vector<PmXmlTagName> names = {
+            { QLatin1String("preset"), PmXmlTag::Preset },
+            { QLatin1String("name"), PmXmlTag::Name },
+            { QLatin1String("match_config"), PmXmlTag::MatchConfig },
+            { QLatin1String("label"), PmXmlTag::Label },
+            { QLatin1String("match_image_filename"),
+              PmXmlTag::MatchImageFilename },
+            { QLatin1String("was_downloaded"), PmXmlTag::WasDownloaded },
+            { QLatin1String("roi_left"), PmXmlTag::RoiLeft },
+            { QLatin1String("roi_bottom"), PmXmlTag::RoiBottom },
+            { QLatin1String("per_pixel_allowed_error"),
+              PmXmlTag::PerPixelAllowedError },
+            { QLatin1String("total_match_threshold"),
+              PmXmlTag::TotalMatchThreshold },
+            { QLatin1String("invert_result"), PmXmlTag::InvertResult },
+            { QLatin1String("mask_mode"), PmXmlTag::MaskMode },
+            { QLatin1String("mask_alpha"), PmXmlTag::MaskAlpha },
+            { QLatin1String("mask_color_r"), PmXmlTag::MaskColorR },
+            { QLatin1String("mask_color_g"), PmXmlTag::MaskColorG },
+            { QLatin1String("mask_color_b"), PmXmlTag::MaskColorB },
+            { QLatin1String("is_enabled"), PmXmlTag::IsEnabled },
+            { QLatin1String("reaction"), PmXmlTag::Reaction },
+            { QLatin1String("linger_ms"), PmXmlTag::LingerMs },
+            { QLatin1String("cooldown_ms"), PmXmlTag::CooldownMs },
+            { QLatin1String("match_actions"), PmXmlTag::MatchActions },
+            { QLatin1String("unmatch_actions"), PmXmlTag::UnmatchActions },
+            { QLatin1String("action"), PmXmlTag::Action },
+            { QLatin1String("action_type"), PmXmlTag::ActionType },
+            { QLatin1String("action_code"), PmXmlTag::ActionCode },
+            { QLatin1String("target_element"), PmXmlTag::TargetElement },
+            { QLatin1String("target_details"), PmXmlTag::TargetDetails },
+            { QLatin1String("hotkey_key"), PmXmlTag::HotkeyKey },
+            { QLatin1String("hotkey_modifiers"), PmXmlTag::HotkeyModifiers },
+            { QLatin1String("date_time_format"), PmXmlTag::DateTimeFormat },
+        };
+        std::sort(names.begin(), names.end(),
+            [](const PmXmlTagName &a, const PmXmlTagName &b) {
+                return a.name < b.name;
+            });
+        return names;
+    }();
+    return ret;
+}
+
+PmXmlTag pmXmlTag(QStringView name)
+{
+    // binary search over views; no string is built for the lookup
+    const auto &names = sortedTagNames();
+    auto find = std::lower_bound(names.begin(), names.end(), name,
+        [](const PmXmlTagName &entry, QStringView key) {
+            return key.compare(entry.name) > 0;
+        });
+    if (find != names.end() && name.compare(find->name) == 0)
+        return find->tag;
+    return PmXmlTag::Unknown;
+}
+
+std::string pmXmlReadString(QXmlStreamReader &reader)
+{
+    // encoded straight into the result, without a QByteArray in between
+    QString text = reader.readElementText();
+    QStringEncoder toUtf8(QStringEncoder::Utf8);
+    std::string ret(toUtf8.requiredSpace(text.size()), '\0');
+    char *end = toUtf8.appendToBuffer(ret.data(), text);
+    ret.resize(size_t(end - ret.data()));
+    return ret;
+}
+
+bool pmXmlReadBool(QXmlStreamReader &reader)
+{
+    return reader.readElementText() == QLatin1String("true");
+}
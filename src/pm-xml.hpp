@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QStringView>
+#include <QXmlStreamReader>
+
+#include <string>
+
+/**
+ * @brief Element names of the preset XML schema. Readers map each element
+ *        name to a tag once and dispatch on the tag, instead of building a
+ *        QString per element and comparing it against every known name.
+ */
+enum class PmXmlTag : unsigned char {
+    Unknown = 0,
+    // presets
+    Preset, Name, MatchConfig,
+    // match entries
+    Label, MatchImageFilename, WasDownloaded, RoiLeft, RoiBottom,
+    PerPixelAllowedError, TotalMatchThreshold, InvertResult, MaskMode,
+    MaskAlpha, MaskColorR, MaskColorG, MaskColorB, IsEnabled,
+    // reactions
+    Reaction, LingerMs, CooldownMs, MatchActions, UnmatchActions,
+    // actions
+    Action, ActionType, ActionCode, TargetElement, TargetDetails,
+    HotkeyKey, HotkeyModifiers, DateTimeFormat
+};
+
+PmXmlTag pmXmlTag(QStringView name);
+
+/** @brief Tag of the reader's current element */
+inline PmXmlTag pmXmlTag(const QXmlStreamReader &reader)
+    { return pmXmlTag(reader.name()); }
+
+// text of the current element; the reader moves to the element's end
+std::string pmXmlReadString(QXmlStreamReader &reader);
+bool pmXmlReadBool(QXmlStreamReader &reader);
@@ -0,0 +1,68 @@
+#include "pm-decision-engine.hpp"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// usage: pm-decision-engine-bench [entries] [frames]
+int main(int argc, char **argv)
+{
+    size_t numEntries = argc > 1 ? strtoul(argv[1], nullptr, 10) : 500;
+    size_t numFrames = argc > 2 ? strtoul(argv[2], nullptr, 10) : 20000;
+    const uint64_t frameNs = 16666667;
+
+    // a mix of plain, lingering, cooling down and scene switching entries
+    PmCompiledConfig cc;
+    cc.totalMatchThresh.assign(numEntries, 50.f);
+    cc.invertResult.assign(numEntries, 0);
+    cc.isEnabled.assign(numEntries, 1);
+    cc.hasReaction.assign(numEntries, 1);
+    cc.hasSceneAction.assign(numEntries, 0);
+    cc.hasMatchSceneAction.assign(numEntries, 0);
+    cc.hasSetMatchActions.assign(numEntries, 1);
+    cc.hasSetUnmatchActions.assign(numEntries, 1);
+    cc.lingerMs.assign(numEntries, 0);
+    cc.cooldownMs.assign(numEntries, 0);
+    cc.matchScene.resize(numEntries);
+    cc.unmatchScene.resize(numEntries);
+    for (size_t i = 0; i < numEntries; ++i) {
+        if (i % 3 == 1)
+            cc.lingerMs[i] = uint32_t(50 + i % 500);
+        if (i % 5 == 2)
+            cc.cooldownMs[i] = uint32_t(100 + i % 700);
+        if (i % 7 == 0) {
+            cc.hasSceneAction[i] = 1;
+            cc.hasMatchSceneAction[i] = 1;
+            cc.matchScene[i].sceneExists = true;
+            cc.unmatchScene[i].sceneExists = true;
+        }
+    }
+
+    PmDecisionEngine engine;
+    PmDecisionList decisions;
+    PmMultiMatchResults results(numEntries);
+    size_t numDecisions = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < numFrames; ++frame) {
+        // each entry flips on its own period, so a few change every frame
+        for (size_t i = 0; i < numEntries; ++i) {
+            PmMatchResults &r = results[i];
+            r.isReady = true;
+            r.numCompared = 100;
+            r.numMatched = ((frame + i) / (10 + i % 90)) % 2 ? 100 : 0;
+        }
+        engine.process(cc, results, frame * frameNs, true, decisions);
+        numDecisions += decisions.size();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    double ns = double(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    printf("%zu entries, %zu frames: %.0f ns/frame, %.1f ns/entry, "
+           "%zu decisions\n",
+           numEntries, numFrames, ns / double(numFrames),
+           ns / double(numFrames) / double(numEntries ? numEntries : 1),
+           numDecisions);
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include "pm-decision-engine.hpp"
+
+#include <initializer_list>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define PM_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", \
+                    __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint64_t ms(uint64_t t) { return t * 1000000; }
+
+// every entry has match and unmatch actions, and no scene actions
+static void compile(PmCompiledConfig &cc, size_t sz,
+                    uint32_t lingerMs, uint32_t cooldownMs)
+{
+    cc.totalMatchThresh.assign(sz, 50.f);
+    cc.invertResult.assign(sz, 0);
+    cc.isEnabled.assign(sz, 1);
+    cc.hasReaction.assign(sz, 1);
+    cc.hasSceneAction.assign(sz, 0);
+    cc.hasMatchSceneAction.assign(sz, 0);
+    cc.hasSetMatchActions.assign(sz, 1);
+    cc.hasSetUnmatchActions.assign(sz, 1);
+    cc.lingerMs.assign(sz, lingerMs);
+    cc.cooldownMs.assign(sz, cooldownMs);
+    cc.matchScene.resize(sz);
+    cc.unmatchScene.resize(sz);
+}
+
+static PmMultiMatchResults results(std::initializer_list<bool> matched)
+{
+    PmMultiMatchResults ret;
+    for (bool m : matched) {
+        PmMatchResults r;
+        r.isReady = true;
+        r.numCompared = 100;
+        r.numMatched = m ? 100 : 0;
+        ret.push_back(r);
+    }
+    return ret;
+}
+
+static size_t count(const PmDecisionList &decisions,
+                    PmDecisionType type, size_t matchIdx, bool on)
+{
+    size_t ret = 0;
+    for (const PmDecision &d : decisions) {
+        if (d.type == type && d.matchIdx == matchIdx && d.on == on)
+            ret++;
+    }
+    return ret;
+}
+
+static void testLingerExpiry()
+{
+    PmCompiledConfig cc;
+    compile(cc, 1, 100, 0);
+    PmDecisionEngine engine;
+    PmDecisionList decisions;
+
+    auto res = results({true});
+    engine.process(cc, res, ms(0), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, true) == 1);
+
+    // unmatch starts the linger instead of the unmatch actions
+    res = results({false});
+    engine.process(cc, res, ms(10), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 0, true) == 1);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, false) == 0);
+    PM_CHECK(engine.isLingering(0));
+    PM_CHECK(engine.nextDeadline() == ms(110));
+
+    res = results({false});
+    engine.process(cc, res, ms(109), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 0, false) == 0);
+    PM_CHECK(engine.isLingering(0));
+
+    // still unmatched at the deadline: the unmatch happens now
+    res = results({false});
+    engine.process(cc, res, ms(110), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 0, false) == 1);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, false) == 1);
+    PM_CHECK(!engine.isLingering(0));
+    PM_CHECK(engine.nextDeadline() == UINT64_MAX);
+
+    // and only once
+    res = results({false});
+    engine.process(cc, res, ms(200), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, false) == 0);
+}
+
+static void testRematchCancelsLinger()
+{
+    PmCompiledConfig cc;
+    compile(cc, 1, 100, 0);
+    PmDecisionEngine engine;
+    PmDecisionList decisions;
+
+    auto res = results({true});
+    engine.process(cc, res, ms(0), true, decisions);
+    res = results({false});
+    engine.process(cc, res, ms(10), true, decisions);
+    PM_CHECK(engine.isLingering(0));
+
+    res = results({true});
+    engine.process(cc, res, ms(50), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 0, false) == 1);
+    PM_CHECK(!engine.isLingering(0));
+
+    // the cancelled deadline is stale and never fires
+    PM_CHECK(engine.nextDeadline() == UINT64_MAX);
+    res = results({true});
+    engine.process(cc, res, ms(110), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 0, false) == 0);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, false) == 0);
+}
+
+static void testCooldownExpiry()
+{
+    PmCompiledConfig cc;
+    compile(cc, 1, 0, 200);
+    PmDecisionEngine engine;
+    PmDecisionList decisions;
+
+    auto res = results({true});
+    engine.process(cc, res, ms(0), true, decisions);
+    res = results({false});
+    engine.process(cc, res, ms(10), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, false) == 1);
+    PM_CHECK(count(decisions, PmDecisionType::CooldownActive, 0, true) == 1);
+    PM_CHECK(engine.isCoolingDown(0));
+    PM_CHECK(engine.nextDeadline() == ms(210));
+
+    // no switching on while cooling down
+    res = results({true});
+    engine.process(cc, res, ms(50), true, decisions);
+    PM_CHECK(!res[0].isMatched);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, true) == 0);
+
+    res = results({true});
+    engine.process(cc, res, ms(210), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::CooldownActive, 0, false) == 1);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, true) == 1);
+    PM_CHECK(!engine.isCoolingDown(0));
+}
+
+static void testCooldownStartsAtLingerDeadline()
+{
+    PmCompiledConfig cc;
+    compile(cc, 1, 100, 200);
+    PmDecisionEngine engine;
+    PmDecisionList decisions;
+
+    auto res = results({true});
+    engine.process(cc, res, ms(0), true, decisions);
+    res = results({false});
+    engine.process(cc, res, ms(10), true, decisions);
+    PM_CHECK(engine.nextDeadline() == ms(110));
+
+    // the frame arrives well after the linger deadline; the cooldown is
+    // still counted from the deadline, not from the frame
+    res = results({false});
+    engine.process(cc, res, ms(150), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 0, false) == 1);
+    PM_CHECK(count(decisions, PmDecisionType::RunActions, 0, false) == 1);
+    PM_CHECK(count(decisions, PmDecisionType::CooldownActive, 0, true) == 1);
+    PM_CHECK(engine.isCoolingDown(0));
+    PM_CHECK(engine.nextDeadline() == ms(310));
+
+    res = results({false});
+    engine.process(cc, res, ms(310), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::CooldownActive, 0, false) == 1);
+    PM_CHECK(!engine.isCoolingDown(0));
+}
+
+static void testDeadlineOrder()
+{
+    PmCompiledConfig cc;
+    compile(cc, 2, 100, 0);
+    cc.lingerMs[1] = 50;
+    PmDecisionEngine engine;
+    PmDecisionList decisions;
+
+    auto res = results({true, true});
+    engine.process(cc, res, ms(0), true, decisions);
+    res = results({false, false});
+    engine.process(cc, res, ms(10), true, decisions);
+    PM_CHECK(engine.nextDeadline() == ms(60));
+
+    // both deadlines are due; each expires once
+    res = results({false, false});
+    engine.process(cc, res, ms(500), true, decisions);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 0, false) == 1);
+    PM_CHECK(count(decisions, PmDecisionType::LingerActive, 1, false) == 1);
+    PM_CHECK(decisions.size() >= 2
+          && decisions[0].matchIdx == 1 && decisions[1].matchIdx == 0);
+    PM_CHECK(engine.nextDeadline() == UINT64_MAX);
+}
+
+int main()
+{
+    testLingerExpiry();
+    testRematchCancelsLinger();
+    testCooldownExpiry();
+    testCooldownStartsAtLingerDeadline();
+    testDeadlineOrder();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
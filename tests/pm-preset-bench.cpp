@@ -0,0 +1,145 @@
+#include "pm-structs.hpp"
+
+#include <QTemporaryDir>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// normally provided by the module's locale
+const char *obs_module_text(const char *lookupString)
+{
+    return lookupString;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+static PmAction makeAction(PmActionType type, size_t n)
+{
+    PmAction action;
+    action.actionType = type;
+    action.targetElement = "target element " + std::to_string(n);
+    action.targetDetails = "target details " + std::to_string(n);
+    action.actionCode = n % 3;
+    return action;
+}
+
+static PmMultiMatchConfig makePreset(size_t numEntries, size_t seed)
+{
+    PmMultiMatchConfig mcfg;
+    for (size_t i = 0; i < numEntries; ++i) {
+        size_t n = seed * numEntries + i;
+        PmMatchConfig cfg;
+        cfg.label = "entry " + std::to_string(n);
+        cfg.matchImgFilename = "images/match image " + std::to_string(n) + ".png";
+        cfg.totalMatchThresh = float(50 + n % 50);
+        cfg.invertResult = (n % 4 == 0);
+        cfg.filterCfg.roi_left = int(n % 1920);
+        cfg.filterCfg.roi_bottom = int(n % 1080);
+        cfg.reaction.lingerMs = uint32_t(n % 1000);
+        cfg.reaction.cooldownMs = uint32_t(n % 700);
+        cfg.reaction.matchActions.push_back(
+            makeAction(PmActionType::SceneItem, n));
+        cfg.reaction.matchActions.push_back(
+            makeAction(PmActionType::Filter, n));
+        cfg.reaction.unmatchActions.push_back(
+            makeAction(PmActionType::SceneItem, n));
+        if (i % 5 == 0) {
+            cfg.reaction.matchActions.push_back(
+                makeAction(PmActionType::Scene, n));
+        }
+        mcfg.push_back(cfg);
+    }
+    mcfg.noMatchReaction.matchActions.push_back(
+        makeAction(PmActionType::Scene, seed));
+    return mcfg;
+}
+
+// usage: pm-preset-bench [presets] [entries per preset]
+int main(int argc, char **argv)
+{
+    size_t numPresets = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200;
+    size_t numEntries = argc > 2 ? strtoul(argv[2], nullptr, 10) : 20;
+
+    PmMatchPresets presets;
+    QList<std::string> presetNames;
+    for (size_t p = 0; p < numPresets; ++p) {
+        std::string name = "preset " + std::to_string(p);
+        presets.insert(name, makePreset(numEntries, p));
+        presetNames.push_back(name);
+    }
+    printf("%zu presets x %zu entries\n", numPresets, numEntries);
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        fprintf(stderr, "unable to create a temporary folder\n");
+        return 1;
+    }
+    std::string filename
+        = tempDir.filePath("presets.xml").toUtf8().data();
+
+    try {
+        // XML export/import
+        auto start = std::chrono::steady_clock::now();
+        presets.exportXml(filename, presetNames);
+        printf("exportXml:   %9.2f ms\n", elapsedMs(start));
+
+        start = std::chrono::steady_clock::now();
+        PmMatchPresets imported(filename);
+        printf("importXml:   %9.2f ms\n", elapsedMs(start));
+
+        if (imported != presets) {
+            fprintf(stderr, "imported presets differ from exported ones\n");
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    // obs_data save/load, including the JSON text OBS keeps on disk
+    std::vector<obs_data_t *> saved;
+    saved.reserve(size_t(presets.size()));
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &name : presetNames) {
+        saved.push_back(presets[name].save(name));
+    }
+    printf("save:        %9.2f ms\n", elapsedMs(start));
+
+    std::vector<std::string> json;
+    json.reserve(saved.size());
+    start = std::chrono::steady_clock::now();
+    for (obs_data_t *obj : saved) {
+        json.push_back(obs_data_get_json(obj));
+        obs_data_release(obj);
+    }
+    printf("to json:     %9.2f ms\n", elapsedMs(start));
+
+    start = std::chrono::steady_clock::now();
+    std::vector<obs_data_t *> parsed;
+    parsed.reserve(json.size());
+    for (const std::string &text : json) {
+        parsed.push_back(obs_data_create_from_json(text.data()));
+    }
+    printf("from json:   %9.2f ms\n", elapsedMs(start));
+
+    start = std::chrono::steady_clock::now();
+    PmMatchPresets loaded;
+    for (int i = 0; i < presetNames.size(); ++i) {
+        loaded.insert(presetNames[i], PmMultiMatchConfig(parsed[size_t(i)]));
+    }
+    printf("load:        %9.2f ms\n", elapsedMs(start));
+
+    for (obs_data_t *obj : parsed) {
+        obs_data_release(obj);
+    }
+    if (loaded != presets) {
+        fprintf(stderr, "loaded presets differ from saved ones\n");
+        return 1;
+    }
+    return 0;
+}
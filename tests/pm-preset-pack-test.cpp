@@ -0,0 +1,107 @@
+#include "pm-preset-pack.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define PM_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", \
+                    __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+// normally provided by the module's locale
+const char *obs_module_text(const char *lookupString)
+{
+    return lookupString;
+}
+
+static bool writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+static QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// local file names that the pack reader would refuse as image names still
+// export, under a replacement name, and the pack imports
+static void testImageNameRoundTrip()
+{
+    QTemporaryDir tempDir;
+    PM_CHECK(tempDir.isValid());
+    QDir dir(tempDir.path());
+    PM_CHECK(dir.mkdir("images") && dir.mkdir("extracted"));
+
+    QStringList names = {"plain.png", "a..b.png", "c..d.png"};
+#ifndef _WIN32
+    names << "shot 12:30.png";
+#endif
+
+    PmMultiMatchConfig mcfg;
+    QList<QByteArray> contents;
+    for (const QString &name : names) {
+        QString path = dir.filePath("images/" + name);
+        QByteArray data = ("pixels of " + name).toUtf8();
+        PM_CHECK(writeFile(path, data));
+        contents.push_back(data);
+
+        PmMatchConfig cfg;
+        cfg.matchImgFilename = path.toUtf8().data();
+        mcfg.push_back(cfg);
+    }
+    PmMatchPresets presets;
+    presets.insert("preset", mcfg);
+
+    std::string packFilename = dir.filePath("test.pmpack").toUtf8().data();
+    try {
+        PmPresetPack::write(packFilename, presets, {"preset"});
+        PM_CHECK(PmPresetPack::isPack(packFilename));
+
+        PmPresetPack pack(packFilename);
+        PmMultiMatchConfig imported = pack.preset("preset");
+        PM_CHECK(imported.size() == mcfg.size());
+
+        QSet<std::string> imageNames;
+        for (size_t i = 0; i < imported.size(); ++i) {
+            const std::string &imageName = imported[i].matchImgFilename;
+            imageNames.insert(imageName);
+            PM_CHECK(pack.containsImage(imageName));
+            PM_CHECK(imageName.find("..") == std::string::npos);
+            PM_CHECK(imageName.find(':') == std::string::npos);
+
+            QString dest = dir.filePath(
+                QString("extracted/") + imageName.data());
+            PM_CHECK(pack.extractImage(imageName, dest.toUtf8().data()));
+            PM_CHECK(readFile(dest) == contents[int(i)]);
+        }
+        PM_CHECK(imported[0].matchImgFilename == "plain.png");
+        PM_CHECK(imageNames.size() == names.size());
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        failures++;
+    }
+}
+
+int main()
+{
+    testImageNameRoundTrip();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}